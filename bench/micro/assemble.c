@@ -0,0 +1,82 @@
+#include "ir.h"
+#include "report.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_REPEATS 5
+
+/* Function-sized objects: a loop with a branch, a call and a return */
+void bench_build_ir(fuco_ir_t *ir, size_t n_objects) {
+    fuco_threadpool_t pool;
+
+    ir->label = n_objects + 1; /* Global labels, 0 is startup */
+    fuco_ir_create_startup_object(ir, 1);
+
+    for (size_t i = 1; i <= n_objects; i++) {
+        size_t obj = fuco_ir_add_object(ir, i, NULL);
+        fuco_ir_label_t loop = fuco_ir_next_label(ir, obj);
+        fuco_ir_label_t end = fuco_ir_next_label(ir, obj);
+
+        fuco_ir_add_label(ir, obj, loop);
+        fuco_ir_add_instr_imm48(ir, obj, FUCO_OPCODE_QRLOAD, -24);
+        fuco_ir_add_instr_imm48(ir, obj, FUCO_OPCODE_QPUSH, 1);
+        fuco_ir_add_instr(ir, obj, FUCO_OPCODE_ILE);
+        fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_BRTRUE, end);
+        fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_CALL,
+                                      i % n_objects + 1);
+        fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_JUMP, loop);
+        fuco_ir_add_label(ir, obj, end);
+        fuco_ir_add_instr_imm48(ir, obj, FUCO_OPCODE_QRET, 8);
+    }
+
+    /* Relocates local labels, objects without definitions are not
+       analyzed */
+    fuco_threadpool_init(&pool, 0);
+    fuco_ir_generate(ir, NULL, &pool);
+    fuco_threadpool_destruct(&pool);
+}
+
+void bench_assemble(size_t n_objects, size_t n_threads) {
+    fuco_ir_t ir;
+    fuco_bytecode_t bytecode;
+    fuco_threadpool_t pool;
+    double best = 0.0;
+
+    fuco_ir_init(&ir);
+    fuco_bytecode_init(&bytecode);
+    bench_build_ir(&ir, n_objects);
+    fuco_threadpool_init(&pool, n_threads);
+
+    for (size_t i = 0; i < BENCH_REPEATS; i++) {
+        double start = fuco_clock_now();
+        fuco_ir_assemble(&ir, &bytecode, &pool);
+        double elapsed = fuco_clock_now() - start;
+
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    printf("assemble objects=%-8zu threads=%zu %7.2f ns/instr  "
+           "%8.3f ms  (%zu instrs)\n", n_objects, n_threads,
+           best / bytecode.size * 1e9, best * 1e3, bytecode.size);
+
+    fuco_threadpool_destruct(&pool);
+    fuco_bytecode_destruct(&bytecode);
+    fuco_ir_destruct(&ir);
+}
+
+int main(void) {
+    static size_t sizes[] = { 1000, 10000, 100000, 1000000 };
+    size_t n_threads = fuco_threadpool_default_size();
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        bench_assemble(sizes[i], 0);
+
+        if (n_threads > 1) {
+            bench_assemble(sizes[i], n_threads);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "lexer.h"
+#include "report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#define BENCH_REPEATS 5
+
+/* Representative mix: comments, indentation, identifiers, keywords,
+   numbers and operators */
+static char const bench_snippet[] =
+    "# Computes the distance between two values, comments are skipped\n"
+    "def distance_between(first_value: Int, second_value: Int) -> Int {\n"
+    "    return first_value - second_value * 1024 + 65536 / 17;\n"
+    "}\n"
+    "\n"
+    "def is_less_or_equal(a: Int, b: Int) -> Bool {\n"
+    "    return a <= b;   # trailing comment\n"
+    "}\n"
+    "\n";
+
+double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int bench_write_source(char *filename, size_t size) {
+    int fd = mkstemp(filename);
+    FILE *file;
+
+    if (fd == -1 || (file = fdopen(fd, "w")) == NULL) {
+        perror("lexer bench");
+        return 1;
+    }
+
+    for (size_t n = 0; n < size; n += sizeof(bench_snippet) - 1) {
+        fputs(bench_snippet, file);
+    }
+
+    fclose(file);
+
+    return 0;
+}
+
+int bench_lexer(size_t size) {
+    char filename[] = "/tmp/fuco-lexer-bench-XXXXXX";
+    double best = 0.0, bytes = 0.0;
+    size_t n_tokens = 0;
+
+    if (bench_write_source(filename, size)) {
+        return 1;
+    }
+
+    for (size_t i = 0; i < BENCH_REPEATS; i++) {
+        fuco_lexer_t lexer;
+        fuco_lexer_init(&lexer);
+        fuco_lexer_add_job(&lexer, filename);
+
+        size_t heap = fuco_heap_in_use();
+        double start = bench_now();
+        fuco_tstream_t tstream = fuco_lexer_lex(&lexer);
+        double elapsed = bench_now() - start;
+
+        if (tstream == NULL) {
+            fuco_lexer_destruct(&lexer);
+            unlink(filename);
+            return 1;
+        }
+
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+
+        n_tokens = lexer.list.size;
+        bytes = (double)(fuco_heap_in_use() - heap) / n_tokens;
+        size = fuco_sourcefiles_get(lexer.files[0])->size;
+
+        fuco_lexer_destruct(&lexer);
+        fuco_sourcefiles_destruct();
+    }
+
+    printf("lexer size=%-9zu %8.1f MB/s  %6.2f ns/token  %6.1f B/token"
+           "  (%zu tokens)\n", size, size / best * 1e3, best / n_tokens, 
+           bytes, n_tokens);
+
+    unlink(filename);
+
+    return 0;
+}
+
+int main(void) {
+    static size_t sizes[] = { 64 << 10, 1 << 20, 16 << 20 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        if (bench_lexer(sizes[i])) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "map.h"
+#include "strutils.h"
+#include "report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#define BENCH_LOOKUPS 2000000
+
+#define BENCH_KEY_SIZE 24
+
+uint64_t bench_xorshift(uint64_t *state) {
+    uint64_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    return *state = x;
+}
+
+double bench_lookups(fuco_map_t *map, char *keys, size_t n,
+                     uint64_t *checksum) {
+    uint64_t state = 88172645463325252ULL;
+    double start = fuco_clock_now();
+
+    for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+        char *key = keys + bench_xorshift(&state) % n * BENCH_KEY_SIZE;
+        void **value = fuco_map_lookup(map, key);
+
+        *checksum += value == NULL ? 0 : (uintptr_t)*value;
+    }
+
+    return (fuco_clock_now() - start) / BENCH_LOOKUPS * 1e9;
+}
+
+/* Misses use keys absent from the map, only the first n are inserted */
+void bench_map(size_t n) {
+    char *keys = malloc(2 * n * BENCH_KEY_SIZE);
+    uint64_t checksum = 0;
+
+    for (size_t i = 0; i < 2 * n; i++) {
+        snprintf(keys + i * BENCH_KEY_SIZE, BENCH_KEY_SIZE, "key%zu", i);
+    }
+
+    fuco_map_t map;
+    fuco_map_init(&map, fuco_string_hash, fuco_string_equal, NULL, NULL);
+
+    size_t heap = fuco_heap_in_use();
+    double start = fuco_clock_now();
+
+    for (size_t i = 0; i < n; i++) {
+        fuco_map_insert(&map, keys + i * BENCH_KEY_SIZE, (void *)(i + 1));
+    }
+
+    double insert = (fuco_clock_now() - start) / n * 1e9;
+    double bytes = (double)(fuco_heap_in_use() - heap) / n;
+
+    double hit = bench_lookups(&map, keys, n, &checksum);
+    double miss = bench_lookups(&map, keys + n * BENCH_KEY_SIZE, n,
+                                &checksum);
+
+    printf("map n=%-8zu insert %7.2f ns/op  hit %7.2f ns/op  "
+           "miss %7.2f ns/op  %6.1f B/elem  (checksum %lu)\n",
+           n, insert, hit, miss, bytes, checksum);
+
+    fuco_map_destruct(&map);
+    free(keys);
+}
+
+int main(void) {
+    static size_t sizes[] = { 1000, 10000, 100000, 1000000 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        bench_map(sizes[i]);
+    }
+
+    return 0;
+}
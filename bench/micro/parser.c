@@ -0,0 +1,99 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "compiler.h"
+#include "report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define BENCH_REPEATS 5
+
+/* Declarations, nested control flow and mixed-precedence expressions */
+static char const bench_snippet[] =
+    "def step(x: Int, y: Int) -> Int {\n"
+    "    if (x < y * 2 + 1) {\n"
+    "        while (x != y) {\n"
+    "            return step(x + 1, y) - (x % 3) * y;\n"
+    "        }\n"
+    "    } else {\n"
+    "        return %iadd(x, y / 4 - 7);\n"
+    "    }\n"
+    "    return x * (y + 1) <= 100 - y;\n"
+    "}\n"
+    "\n";
+
+int bench_write_source(char *filename, size_t size) {
+    int fd = mkstemp(filename);
+    FILE *file;
+
+    if (fd == -1 || (file = fdopen(fd, "w")) == NULL) {
+        perror("parser bench");
+        return 1;
+    }
+
+    for (size_t n = 0; n < size; n += sizeof(bench_snippet) - 1) {
+        fputs(bench_snippet, file);
+    }
+
+    fclose(file);
+
+    return 0;
+}
+
+/* Lexing streams into parsing, so the throughput includes both */
+int bench_parser(size_t size) {
+    char filename[] = "/tmp/fuco-parser-bench-XXXXXX";
+    double best = 0.0, bytes = 0.0;
+    size_t n_tokens = 0;
+
+    if (bench_write_source(filename, size)) {
+        return 1;
+    }
+
+    for (size_t i = 0; i < BENCH_REPEATS; i++) {
+        fuco_unit_t unit;
+        fuco_unit_init(&unit, filename, false);
+
+        size_t heap = fuco_heap_in_use();
+        double start = fuco_clock_now();
+        fuco_unit_parse(&unit);
+        double elapsed = fuco_clock_now() - start;
+
+        if (unit.root == NULL) {
+            fuco_unit_destruct(&unit);
+            unlink(filename);
+            return 1;
+        }
+
+        if (i == 0 || elapsed < best) {
+            best = elapsed;
+        }
+
+        n_tokens = unit.n_tokens;
+        bytes = (double)(fuco_heap_in_use() - heap) / n_tokens;
+        size = fuco_sourcefiles_get(unit.lexer.files[0])->size;
+
+        fuco_unit_destruct(&unit);
+        fuco_sourcefiles_destruct();
+    }
+
+    printf("parser size=%-9zu %8.1f MB/s  %6.2f ns/token  %6.1f B/token"
+           "  (%zu tokens)\n", size, size / best * 1e-6,
+           best / n_tokens * 1e9, bytes, n_tokens);
+
+    unlink(filename);
+
+    return 0;
+}
+
+int main(void) {
+    static size_t sizes[] = { 64 << 10, 1 << 20, 16 << 20 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        if (bench_parser(sizes[i])) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
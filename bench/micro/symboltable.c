@@ -0,0 +1,71 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "symbol.h"
+#include "report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#define BENCH_LOOKUPS 10000000
+
+double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+uint64_t bench_xorshift(uint64_t *state) {
+    uint64_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    return *state = x;
+}
+
+void bench_symboltable(size_t n) {
+    fuco_symboltable_t table;
+    fuco_symboltable_init(&table);
+
+    size_t heap = fuco_heap_in_use();
+    double start = bench_now();
+
+    for (size_t i = 0; i < n; i++) {
+        fuco_symboltable_insert(&table, NULL, &null_token, NULL, 
+                                FUCO_SYMBOL_VARIABLE);
+    }
+
+    double insert = (bench_now() - start) / n;
+    double bytes = (double)(fuco_heap_in_use() - heap) / n;
+
+    uint64_t state = 88172645463325252ULL;
+    uint64_t checksum = 0;
+
+    start = bench_now();
+
+    for (size_t i = 0; i < BENCH_LOOKUPS; i++) {
+        fuco_symbolid_t id = bench_xorshift(&state) % n;
+        checksum += fuco_symboltable_lookup(&table, id)->id;
+    }
+
+    double lookup = (bench_now() - start) / BENCH_LOOKUPS;
+
+    printf("symboltable n=%-8zu insert %6.2f ns/op  lookup %6.2f ns/op"
+           "  %6.1f B/elem  (checksum %lu)\n", n, insert, lookup, bytes, 
+           checksum);
+
+    fuco_symboltable_destruct(&table);
+}
+
+int main(void) {
+    static size_t sizes[] = { 1000, 10000, 100000, 1000000 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+        bench_symboltable(sizes[i]);
+    }
+
+    return 0;
+}
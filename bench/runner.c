@@ -0,0 +1,325 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE /* wait4 */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+/* Runs each benchmark program through fuco --run, or only compiles it with
+   --compile, and reports wall time statistics and peak memory. Results are
+   written as one JSON object per line inside an array, which is also the
+   baseline format read by --compare */
+
+#define BENCH_MAX_REPS 1000
+
+#define BENCH_NAME_SIZE 256
+
+typedef struct {
+    char const *fuco;
+    char const *prelude;
+    char const *json;
+    char const *compare;
+    int warmup;
+    int reps;
+    double threshold; /* Percent slowdown of the median flagged */
+    bool compile; /* Measure compilation only */
+} bench_options_t;
+
+typedef struct {
+    char name[BENCH_NAME_SIZE];
+    double min;
+    double median;
+    double p95;
+    int status; /* Exit code of the program, a checksum across runs */
+    size_t bytes; /* Source size including the prelude */
+    size_t peak_rss;
+} bench_result_t;
+
+double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void bench_usage(char const *name) {
+    fprintf(stderr,
+            "usage: %s [options] <fuco> <program.fc>...\n"
+            "options:\n"
+            "  --prelude=<file>     compiled before every program\n"
+            "  --compile            compile without running\n"
+            "  --warmup=<n>         unmeasured runs, default 2\n"
+            "  --reps=<n>           measured runs, default 10\n"
+            "  --json=<file>        write results as JSON\n"
+            "  --compare=<file>     compare medians against a baseline\n"
+            "  --threshold=<pct>    slowdown flagged as regression, "
+            "default 5\n", name);
+}
+
+/* Returns the exit code of one run, -1 if it did not exit normally. Peak 
+   RSS of the child is raised into peak_rss */
+int bench_run_once(bench_options_t *options, char const *program, 
+                   size_t *peak_rss) {
+    char const *argv[5];
+    int argc = 0;
+
+    argv[argc++] = options->fuco;
+    if (!options->compile) {
+        argv[argc++] = "--run";
+    }
+    if (options->prelude != NULL) {
+        argv[argc++] = options->prelude;
+    }
+    argv[argc++] = program;
+    argv[argc] = NULL;
+
+    pid_t pid = fork();
+
+    if (pid == -1) {
+        perror("fork");
+        return -1;
+    }
+
+    if (pid == 0) {
+        execv(argv[0], (char **)argv);
+        perror(argv[0]);
+        _exit(127);
+    }
+
+    int status;
+    struct rusage usage;
+
+    if (wait4(pid, &status, 0, &usage) == -1 || !WIFEXITED(status)) {
+        return -1;
+    }
+
+    if ((size_t)usage.ru_maxrss * 1024 > *peak_rss) {
+        *peak_rss = (size_t)usage.ru_maxrss * 1024; /* Kilobytes */
+    }
+
+    return WEXITSTATUS(status);
+}
+
+int bench_compare_double(void const *a, void const *b) {
+    double x = *(double const *)a, y = *(double const *)b;
+
+    return (x > y) - (x < y);
+}
+
+size_t bench_file_size(char const *path) {
+    struct stat st;
+
+    return path != NULL && stat(path, &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+void bench_name(char *name, char const *path) {
+    char const *base = strrchr(path, '/');
+    base = base == NULL ? path : base + 1;
+
+    size_t len = strcspn(base, ".");
+    if (len >= BENCH_NAME_SIZE) {
+        len = BENCH_NAME_SIZE - 1;
+    }
+
+    memcpy(name, base, len);
+    name[len] = '\0';
+}
+
+int bench_run(bench_options_t *options, char const *program,
+              bench_result_t *result) {
+    double times[BENCH_MAX_REPS];
+
+    bench_name(result->name, program);
+    result->bytes = bench_file_size(options->prelude) 
+                    + bench_file_size(program);
+    result->peak_rss = 0;
+
+    for (int i = 0; i < options->warmup; i++) {
+        result->status = bench_run_once(options, program, &result->peak_rss);
+    }
+
+    for (int i = 0; i < options->reps; i++) {
+        double start = bench_now();
+        int status = bench_run_once(options, program, &result->peak_rss);
+        times[i] = bench_now() - start;
+
+        if (status == -1 || (i > 0 && status != result->status)) {
+            fprintf(stderr, "%s: failed or inconsistent exit code %d\n",
+                    program, status);
+            return 1;
+        }
+
+        result->status = status;
+    }
+
+    qsort(times, options->reps, sizeof(double), bench_compare_double);
+
+    size_t n = options->reps;
+    result->min = times[0];
+    result->median = n % 2 ? times[n / 2]
+                           : (times[n / 2 - 1] + times[n / 2]) / 2;
+    result->p95 = times[(size_t)(0.95 * (n - 1) + 0.5)];
+
+    return 0;
+}
+
+void bench_write_json(bench_result_t *results, size_t n, FILE *file) {
+    fprintf(file, "[\n");
+
+    for (size_t i = 0; i < n; i++) {
+        fprintf(file, "{\"name\": \"%s\", \"median\": %.9f, \"p95\": %.9f, "
+                "\"min\": %.9f, \"status\": %d, \"bytes\": %zu, "
+                "\"peak_rss\": %zu}%s\n", results[i].name, results[i].median,
+                results[i].p95, results[i].min, results[i].status,
+                results[i].bytes, results[i].peak_rss, i + 1 < n ? "," : "");
+    }
+
+    fprintf(file, "]\n");
+}
+
+/* Reads the median of name from a file written by bench_write_json,
+   returns 1 if absent */
+int bench_baseline_lookup(FILE *file, char const *name, double *median) {
+    char line[1024];
+    char found[BENCH_NAME_SIZE];
+
+    rewind(file);
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (sscanf(line, "{\"name\": \"%255[^\"]\", \"median\": %lf",
+                   found, median) == 2 && strcmp(found, name) == 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int bench_compare(bench_options_t *options, bench_result_t *results,
+                  size_t n) {
+    FILE *file = fopen(options->compare, "r");
+    int regressions = 0;
+
+    if (file == NULL) {
+        perror(options->compare);
+        return 1;
+    }
+
+    printf("\n%-16s %12s %12s %9s\n", "benchmark", "base (ms)", "now (ms)",
+           "change");
+
+    for (size_t i = 0; i < n; i++) {
+        double base;
+
+        if (bench_baseline_lookup(file, results[i].name, &base)) {
+            printf("%-16s %12s %12.3f %9s\n", results[i].name, "-",
+                   results[i].median * 1e3, "new");
+            continue;
+        }
+
+        double change = (results[i].median / base - 1.0) * 100.0;
+        char const *flag = "";
+
+        if (change > options->threshold) {
+            flag = "  REGRESSION";
+            regressions++;
+        } else if (change < -options->threshold) {
+            flag = "  improved";
+        }
+
+        printf("%-16s %12.3f %12.3f %+8.1f%%%s\n", results[i].name,
+               base * 1e3, results[i].median * 1e3, change, flag);
+    }
+
+    fclose(file);
+
+    return regressions > 0;
+}
+
+int bench_parse_option(bench_options_t *options, char const *arg) {
+    if (strncmp(arg, "--prelude=", 10) == 0) {
+        options->prelude = arg + 10;
+    } else if (strcmp(arg, "--compile") == 0) {
+        options->compile = true;
+    } else if (strncmp(arg, "--warmup=", 9) == 0) {
+        options->warmup = atoi(arg + 9);
+    } else if (strncmp(arg, "--reps=", 7) == 0) {
+        options->reps = atoi(arg + 7);
+    } else if (strncmp(arg, "--json=", 7) == 0) {
+        options->json = arg + 7;
+    } else if (strncmp(arg, "--compare=", 10) == 0) {
+        options->compare = arg + 10;
+    } else if (strncmp(arg, "--threshold=", 12) == 0) {
+        options->threshold = atof(arg + 12);
+    } else {
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    bench_options_t options = { NULL, NULL, NULL, NULL, 2, 10, 5.0, false };
+    int i;
+
+    for (i = 1; i < argc && strncmp(argv[i], "--", 2) == 0; i++) {
+        if (bench_parse_option(&options, argv[i])) {
+            bench_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - i < 2 || options.reps < 1 || options.reps > BENCH_MAX_REPS
+        || options.warmup < 0) {
+        bench_usage(argv[0]);
+        return 1;
+    }
+
+    options.fuco = argv[i++];
+
+    size_t n = argc - i;
+    bench_result_t *results = malloc(n * sizeof(bench_result_t));
+    int error = 0;
+
+    printf("%-16s %12s %12s %12s %8s %12s %10s\n", "benchmark", 
+           "median (ms)", "p95 (ms)", "min (ms)", "status", "input (KiB)", 
+           "RSS (MiB)");
+
+    for (size_t j = 0; j < n; j++) {
+        if (bench_run(&options, argv[i + j], &results[j])) {
+            free(results);
+            return 1;
+        }
+
+        printf("%-16s %12.3f %12.3f %12.3f %8d %12.1f %10.1f\n", 
+               results[j].name, results[j].median * 1e3, 
+               results[j].p95 * 1e3, results[j].min * 1e3, results[j].status,
+               results[j].bytes / 1024.0, results[j].peak_rss / 1048576.0);
+    }
+
+    if (options.json != NULL) {
+        FILE *file = fopen(options.json, "w");
+
+        if (file == NULL) {
+            perror(options.json);
+            error = 1;
+        } else {
+            bench_write_json(results, n, file);
+            fclose(file);
+        }
+    }
+
+    if (options.compare != NULL && bench_compare(&options, results, n)) {
+        error = 1;
+    }
+
+    free(results);
+
+    return error;
+}
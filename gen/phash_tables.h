@@ -0,0 +1,75 @@
+/* Generated by tools/phashgen, do not edit */
+
+static fuco_phash_entry_t const fuco_phash_keywords_entries[] = {
+    { "let", 17 },
+    { "if", 15 },
+    { "def", 9 },
+    { "inline", 10 },
+    { "return", 11 },
+    { "const", 18 },
+    { "for", 14 },
+    { "while", 13 },
+    { "convert", 12 },
+    { "else", 16 }
+};
+
+static fuco_phash_table_t const fuco_phash_keywords = {
+    fuco_phash_keywords_entries, 10, 667
+};
+
+static fuco_phash_entry_t const fuco_phash_separators_entries[] = {
+    { "}", 22 },
+    { ":", 28 },
+    { "{", 21 },
+    { "]", 24 },
+    { ".", 25 },
+    { ";", 27 },
+    { "(", 19 },
+    { "[", 23 },
+    { ",", 26 },
+    { ")", 20 }
+};
+
+static fuco_phash_table_t const fuco_phash_separators = {
+    fuco_phash_separators_entries, 10, 21224
+};
+
+static fuco_phash_entry_t const fuco_phash_operators_entries[] = {
+    { "+", 30 },
+    { "<", 39 },
+    { "<=", 40 },
+    { "->", 29 },
+    { "/", 33 },
+    { ">=", 38 },
+    { "%", 34 },
+    { "*", 32 },
+    { "==", 35 },
+    { "!=", 36 },
+    { "-", 31 },
+    { ">", 37 }
+};
+
+static fuco_phash_table_t const fuco_phash_operators = {
+    fuco_phash_operators_entries, 12, 14874
+};
+
+static fuco_phash_entry_t const fuco_phash_instrs_entries[] = {
+    { "ieq", 14 },
+    { "igt", 18 },
+    { "itof", 20 },
+    { "isub", 10 },
+    { "imul", 11 },
+    { "imod", 13 },
+    { "iadd", 9 },
+    { "ftoi", 21 },
+    { "idiv", 12 },
+    { "ine", 15 },
+    { "ile", 17 },
+    { "ige", 19 },
+    { "ilt", 16 }
+};
+
+static fuco_phash_table_t const fuco_phash_instrs = {
+    fuco_phash_instrs_entries, 13, 41255
+};
+
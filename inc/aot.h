@@ -0,0 +1,58 @@
+#ifndef FUCO_AOT_H
+#define FUCO_AOT_H
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ir.h"
+#include <stdio.h>
+#include <stdint.h>
+
+#define FUCO_AOT_CC "cc"
+
+/* Flags of the shared object run in process, NULL terminated */
+extern char const *fuco_aot_cflags[];
+
+/* Exported by the generated C */
+#define FUCO_AOT_ENTRY "fuco_aot_entry"
+
+/* Stack depth before each instruction of an object, -1 if unreachable.
+   Every value is one word, so depth d is held in local s<d> */
+typedef struct {
+    fuco_ir_object_t *object;
+    int64_t *depths;
+    bool *targets; /* Instructions branched to, labeled in the output */
+    size_t max_depth;
+    bool used; /* Reachable through calls from startup */
+} fuco_aot_function_t;
+
+/* Arity of the function starting at address, -1 if none does */
+int64_t fuco_aot_arity(fuco_ir_t *ir, uint64_t address);
+
+/* Computes depths from the assembled instructions of function->object,
+   returns 1 if they are inconsistent or use unsupported instructions */
+int fuco_aot_analyze(fuco_aot_function_t *function, fuco_ir_t *ir,
+                     fuco_bytecode_t *bytecode);
+
+/* Marks functions reachable from startup, only those are written */
+void fuco_aot_mark_used(fuco_aot_function_t *functions, fuco_ir_t *ir,
+                        fuco_bytecode_t *bytecode);
+
+void fuco_aot_function_write(fuco_aot_function_t *function, fuco_ir_t *ir,
+                             fuco_bytecode_t *bytecode, FILE *file);
+
+/* Translates the assembled program into a C file with one function per
+   object. It builds standalone, or as a shared object exporting
+   FUCO_AOT_ENTRY when FUCO_AOT_SHARED is defined */
+int fuco_aot_write(fuco_ir_t *ir, fuco_bytecode_t *bytecode, FILE *file);
+
+/* Runs the system compiler driver on source without a shell, flags is NULL
+   terminated or NULL. The CC environment variable overrides the driver and
+   is split on whitespace, any other character is passed on literally */
+int fuco_aot_build(char const **flags, char const *source,
+                   char const *output);
+
+/* Compiles the translation with the system compiler into a temporary shared
+   object and runs it in process, status is the program's exit code */
+int fuco_aot_run(fuco_ir_t *ir, fuco_bytecode_t *bytecode, int32_t *status);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef FUCO_ASM_H
+#define FUCO_ASM_H
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "aot.h"
+#include <stdio.h>
+#include <stdint.h>
+
+/* Callee-saved, so allocated slots survive calls without saving them */
+#define FUCO_ASM_N_REGISTERS 5
+
+/* System V integer argument registers */
+#define FUCO_ASM_N_ARG_REGISTERS 6
+
+/* Large enough for any slot or parameter operand */
+#define FUCO_ASM_OPERAND_SIZE 32
+
+/* Instructions over which a stack slot holds a value */
+typedef struct {
+    size_t slot;
+    size_t start;
+    size_t end;
+} fuco_asm_interval_t;
+
+/* Stack slots of the analyzed function are allocated to registers, or to
+   homes in the frame below the saved registers. Parameters passed in
+   registers are stored to homes on entry */
+typedef struct {
+    fuco_aot_function_t *function;
+    int64_t arity;
+    int *registers; /* Per slot, -1 if spilled */
+    size_t *homes; /* Per slot, home index if spilled */
+    bool used[FUCO_ASM_N_REGISTERS];
+    size_t n_used;
+    size_t n_homes;
+} fuco_asm_function_t;
+
+/* Linear scan over the live intervals of the slots, spilling the interval
+   ending last when no register is free */
+void fuco_asm_allocate(fuco_asm_function_t *function);
+
+void fuco_asm_function_destruct(fuco_asm_function_t *function);
+
+void fuco_asm_function_write(fuco_asm_function_t *function, fuco_ir_t *ir,
+                             fuco_bytecode_t *bytecode, FILE *file);
+
+/* Translates the assembled program into x86-64 GNU assembly with a main
+   calling the startup object, returns 1 if it can not be translated */
+int fuco_asm_write(fuco_ir_t *ir, fuco_bytecode_t *bytecode, FILE *file);
+
+/* Assembles and links the translation into executable with the system
+   compiler driver */
+int fuco_asm_build(fuco_ir_t *ir, fuco_bytecode_t *bytecode,
+                   char const *executable);
+
+#endif
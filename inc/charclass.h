@@ -0,0 +1,32 @@
+#ifndef FUCO_CHARCLASS_H
+#define FUCO_CHARCLASS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FUCO_CHAR_SPACE 0x01
+#define FUCO_CHAR_IDENTIFIER_START 0x02
+#define FUCO_CHAR_IDENTIFIER_CONTINUE 0x04
+#define FUCO_CHAR_DIGIT 0x08
+#define FUCO_CHAR_OPERATOR 0x10
+#define FUCO_CHAR_COMMENT 0x20 /* May appear inside a comment */
+
+#define FUCO_CHARCLASS(c, class) \
+        (fuco_charclass_table[(unsigned char)(c)] & (class))
+
+extern uint8_t const fuco_charclass_table[256];
+
+/* Scanning kernels: each returns the first position in [p, end) at which the 
+   byte is not of the scanned class, or end. Uses AVX2 or SSE2 when available, 
+   with a table driven scalar tail */
+char *fuco_scan_identifier(char *p, char *end);
+
+char *fuco_scan_number(char *p, char *end);
+
+/* Stops at the newline terminating the comment, or at a byte that is invalid 
+   in comments */
+char *fuco_scan_comment(char *p, char *end);
+
+char *fuco_scan_space(char *p, char *end);
+
+#endif
@@ -6,21 +6,74 @@
 #include "symbol.h"
 #include "instruction.h"
 #include "tree.h"
+#include "report.h"
 
+#define FUCO_COMPILER_UNITS_INIT_SIZE 4
+
+/* Stages written to stdout by fuco_compiler_run, nothing by default */
+typedef enum {
+    FUCO_EMIT_NONE = 0,
+    FUCO_EMIT_TOKENS = 1 << 0,
+    FUCO_EMIT_AST = 1 << 1,
+    FUCO_EMIT_SYMBOLS = 1 << 2,
+    FUCO_EMIT_IR = 1 << 3,
+    FUCO_EMIT_BYTECODE = 1 << 4
+} fuco_emit_t;
+
+/* Frontend state of a single source file, lexed and parsed independently of 
+   other files. Owns the tokens and mappings its nodes refer to */
 typedef struct {
+    char *filename;
     fuco_lexer_t lexer;    
     fuco_parser_t parser;
+    fuco_node_t *root;
+    size_t n_tokens;
+    bool threaded_lexer; /* Lex on a separate thread while parsing */
+} fuco_unit_t;
+
+typedef struct {
+    fuco_unit_t *units;
+    size_t n_units;
+    size_t cap_units;
     fuco_symboltable_t table;
     fuco_ir_t ir;
     fuco_bytecode_t bytecode;
     fuco_node_t *root;
-    char *filename;
+    size_t n_threads; /* Workers per phase, 0 for one per processor */
+    bool threaded_lexer;
+    unsigned int emit; /* Mask of fuco_emit_t */
+    fuco_report_t *report; /* Filled by fuco_compiler_run if not NULL */
 } fuco_compiler_t;
 
-void fuco_compiler_init(fuco_compiler_t *compiler, char *filename);
+/* Returns the stage named by the n characters at name, or FUCO_EMIT_NONE */
+fuco_emit_t fuco_emit_lookup(char const *name, size_t n);
+
+void fuco_unit_init(fuco_unit_t *unit, char *filename, bool threaded_lexer);
+
+void fuco_unit_destruct(fuco_unit_t *unit);
+
+/* Job function: lexes and parses unit into unit->root, NULL on error */
+void fuco_unit_parse(void *unit);
+
+void fuco_compiler_init(fuco_compiler_t *compiler);
 
 void fuco_compiler_destruct(fuco_compiler_t *compiler);
 
+void fuco_compiler_add_file(fuco_compiler_t *compiler, char *filename);
+
+/* Parses all units on a thread pool and merges their filebodies into 
+   compiler->root in file order */
+int fuco_compiler_parse_units(fuco_compiler_t *compiler);
+
+/* Resolves, generates and assembles all functions on a thread pool */
+int fuco_compiler_generate(fuco_compiler_t *compiler);
+
+/* Lexes every unit separately and writes its tokens, the streaming 
+   pipeline never holds all tokens at once */
+int fuco_compiler_write_tokens(fuco_compiler_t *compiler, FILE *file);
+
+void fuco_compiler_count(fuco_compiler_t *compiler, fuco_report_t *report);
+
 int fuco_compiler_run(fuco_compiler_t *compiler);
 
 #endif
@@ -2,6 +2,7 @@
 #define FUCO_DEFS_H
 
 #include <stdio.h>
+#include <stdint.h>
 
 typedef void(*fuco_free_t)(void *);
 
@@ -11,4 +12,8 @@ typedef struct fuco_symboltable_t fuco_symboltable_t;
 
 typedef struct fuco_node_t fuco_node_t;
 
+typedef struct fuco_profiler_t fuco_profiler_t;
+
+typedef struct fuco_trace_t fuco_trace_t;
+
 #endif
\ No newline at end of file
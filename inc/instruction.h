@@ -89,4 +89,7 @@ void fuco_bytecode_write(fuco_bytecode_t *bytecode, FILE *file);
 
 void fuco_bytecode_add_instr(fuco_bytecode_t *bytecode, fuco_instr_t instr);
 
+/* Grows or shrinks to exactly size instructions, new ones are undefined */
+void fuco_bytecode_resize(fuco_bytecode_t *bytecode, size_t size);
+
 #endif
@@ -2,17 +2,48 @@
 #define FUCO_INTERPRETER_H
 
 #include "instruction.h"
+#include "ir.h"
 #include <assert.h>
 #include <stdbool.h>
 
+/* Not checked on push, deep recursion must fit */
+#define FUCO_PROGRAM_STACK_SIZE ((size_t)16 << 20)
+
 typedef struct {
     char *stack;
     fuco_instr_t *instrs;
     uint64_t ip;
     uint64_t sp;
     uint64_t bp;
+    fuco_trace_t *trace; /* Control transfers are recorded if not NULL */
 } fuco_program_t;
 
+/* Execution profile, only collected when built with FUCO_VM_STATS so the 
+   dispatch loop is unchanged otherwise */
+typedef struct {
+    uint64_t n_instrs;
+    uint64_t opcodes[FUCO_OPCODES_N];
+    uint64_t pairs[FUCO_OPCODES_N][FUCO_OPCODES_N]; /* Previous, current */
+    uint64_t *calls; /* Calls per target address */
+    size_t n_addresses;
+    size_t depth;
+    size_t max_depth;
+    uint64_t max_sp; /* Stack high-water mark in bytes */
+} fuco_vm_stats_t;
+
+#define FUCO_VM_STATS_TOP_PAIRS 16
+
+void fuco_vm_stats_init(fuco_vm_stats_t *stats, size_t n_addresses);
+
+void fuco_vm_stats_destruct(fuco_vm_stats_t *stats);
+
+/* Records instr after it has executed in program */
+void fuco_vm_stats_record(fuco_vm_stats_t *stats, fuco_program_t *program, 
+                          fuco_opcode_t prev, fuco_instr_t instr);
+
+/* Attributes calls to functions through the assembled objects of ir */
+void fuco_vm_stats_write(fuco_vm_stats_t *stats, fuco_ir_t *ir, FILE *file);
+
 void fuco_program_pop(fuco_program_t *program, void *data, size_t size);
 
 void fuco_program_push(fuco_program_t *program, void *data, size_t size);
@@ -28,6 +59,15 @@ void fuco_program_destruct(fuco_program_t *program);
 
 void fuco_program_write_stack(fuco_program_t *program, FILE *file);
 
-int32_t fuco_interpret(fuco_instr_t *program);
+/* Optional observers of execution, each may be NULL. stats is ignored 
+   unless built with FUCO_VM_STATS */
+typedef struct {
+    fuco_vm_stats_t *stats;
+    fuco_profiler_t *profiler;
+    fuco_trace_t *trace;
+} fuco_vm_hooks_t;
+
+/* hooks may be NULL */
+int32_t fuco_interpret(fuco_instr_t *program, fuco_vm_hooks_t *hooks);
 
 #endif
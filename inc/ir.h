@@ -2,8 +2,10 @@
 #define FUCO_IR_H
 
 #include "instruction.h"
+#include "threadpool.h"
 #include "defs.h"
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef uint64_t fuco_ir_label_t;
 
@@ -14,6 +16,9 @@ typedef uint64_t fuco_ir_label_t;
 
 #define FUCO_LABEL_INVALID (fuco_ir_label_t)0
 
+/* Set on labels numbered within their object, cleared by relocation */
+#define FUCO_LABEL_LOCAL ((fuco_ir_label_t)1 << 63)
+
 typedef enum {
     FUCO_IR_LABEL = 0x0, /* Does nothing, more explicit */
     FUCO_IR_INSTR = 0x1,
@@ -39,10 +44,17 @@ typedef struct {
     size_t cap;
     fuco_node_t *def;
     fuco_ir_label_t paramsize_label;
+    size_t n_labels; /* Local labels, relocated from label_base on */
+    fuco_ir_label_t label_base;
+    size_t n_instrs;
+    size_t address; /* Index of the first instruction in the bytecode */
 } fuco_ir_object_t;
 
 #define FUCO_IR_OBJECTS_INIT_SIZE 16
 
+/* Objects per backend job */
+#define FUCO_IR_RANGE_SIZE 64
+
 typedef struct {
     fuco_ir_object_t *objects;
     size_t size;
@@ -50,6 +62,22 @@ typedef struct {
     fuco_ir_label_t label;
 } fuco_ir_t;
 
+/* Contiguous objects handled by a single backend job. Totals are summed per 
+   range in parallel, then scanned serially over ranges only */
+typedef struct {
+    fuco_ir_t *ir;
+    size_t start;
+    size_t end;
+    size_t n_labels;
+    fuco_ir_label_t label_base;
+    size_t n_instrs;
+    size_t address;
+    uint64_t *defs;
+    fuco_bytecode_t *bytecode;
+    fuco_symboltable_t *table;
+    int error;
+} fuco_ir_range_t;
+
 void fuco_ir_unit_write(fuco_ir_unit_t *unit, FILE *file);
 
 void fuco_ir_object_init(fuco_ir_object_t *object, fuco_node_t *def);
@@ -58,13 +86,36 @@ void fuco_ir_object_destruct(fuco_ir_object_t *object);
 
 void fuco_ir_object_write(fuco_ir_object_t *object, FILE *file);
 
+/* Writes the function name and location of the object's definition */
+void fuco_ir_object_write_name(fuco_ir_object_t *object, FILE *file);
+
+/* Whether label is defined before the next instruction from unit i on */
+bool fuco_ir_object_falls_through(fuco_ir_object_t *object, size_t i, 
+                                  fuco_ir_label_t label);
+
+/* Drops jumps to a label directly following them */
+void fuco_ir_object_optimize(fuco_ir_object_t *object);
+
+fuco_ir_label_t fuco_ir_object_relocate_label(fuco_ir_object_t *object, 
+                                              fuco_ir_label_t label);
+
+void fuco_ir_object_relocate(fuco_ir_object_t *object);
+
+void fuco_ir_object_define_labels(fuco_ir_object_t *object, uint64_t *defs);
+
+void fuco_ir_object_emit(fuco_ir_object_t *object, uint64_t *defs, 
+                         fuco_instr_t *instrs);
+
 void fuco_ir_init(fuco_ir_t *ir);
 
 void fuco_ir_destruct(fuco_ir_t *ir);
 
 void fuco_ir_write(fuco_ir_t *ir, FILE *file);
 
-fuco_ir_label_t fuco_ir_next_label(fuco_ir_t *ir);
+/* Returns the assembled object containing address, NULL if out of range */
+fuco_ir_object_t *fuco_ir_object_at(fuco_ir_t *ir, size_t address);
+
+fuco_ir_label_t fuco_ir_next_label(fuco_ir_t *ir, size_t obj);
 
 size_t fuco_ir_add_object(fuco_ir_t *ir, fuco_ir_label_t label, 
                           fuco_node_t *def);
@@ -84,6 +135,29 @@ void fuco_ir_add_instr_imm48_label(fuco_ir_t *ir, size_t obj,
 
 void fuco_ir_create_startup_object(fuco_ir_t *ir, fuco_ir_label_t entry);
 
-void fuco_ir_assemble(fuco_ir_t *ir, fuco_bytecode_t *bytecode);
+fuco_ir_range_t *fuco_ir_ranges_new(fuco_ir_t *ir, size_t *n_ranges);
+
+void fuco_ir_ranges_run(fuco_ir_range_t *ranges, size_t n_ranges, 
+                        fuco_threadpool_t *pool, fuco_job_func_t func);
+
+/* Job functions, each taking a fuco_ir_range_t */
+void fuco_ir_range_generate(void *range);
+
+void fuco_ir_range_relocate(void *range);
+
+void fuco_ir_range_setup(void *range);
+
+void fuco_ir_range_define_labels(void *range);
+
+void fuco_ir_range_emit(void *range);
+
+/* Resolves, generates and optimizes every function object on pool. Labels 
+   are numbered per object, so the result does not depend on scheduling. Each 
+   range stops at its first error */
+int fuco_ir_generate(fuco_ir_t *ir, fuco_symboltable_t *table, 
+                     fuco_threadpool_t *pool);
+
+void fuco_ir_assemble(fuco_ir_t *ir, fuco_bytecode_t *bytecode, 
+                      fuco_threadpool_t *pool);
 
 #endif
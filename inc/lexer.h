@@ -9,26 +9,22 @@
 #include "queue.h"
 #include <stdint.h>
 #include <stdbool.h>
-#include <sys/stat.h>
 
-#define FUCO_LEXER_FILE_BUF_SIZE 1024
+#define FUCO_LEXER_FILES_INIT_SIZE 4
 
+/* Files opened by the lexer stay mapped until it is destructed, tokens refer 
+   to their lexemes by file id and offset */
 typedef struct {
-    char data[FUCO_LEXER_FILE_BUF_SIZE];
-    size_t i;
-    size_t size;
-    bool eof;
-} fuco_filebuf_t;
-
-typedef struct {
-    fuco_filebuf_t filebuf;
-    fuco_strbuf_t strbuf;
+    uint32_t *files;
+    size_t n_files;
+    size_t cap_files;
+    fuco_strtable_t lexemes;
     fuco_tokenlist_t list;
-    fuco_textsource_t start;
-    fuco_textsource_t curr;
     fuco_queue_t jobs;
-    FILE *file;
-    int c;
+    uint32_t file;
+    char *data; /* Mapping of the current file */
+    char *p;
+    char *end;
 } fuco_lexer_t;
 
 bool fuco_is_nontoken(int c);
@@ -43,9 +39,7 @@ bool fuco_is_number_continue(int c);
 
 bool fuco_is_operator(int c);
 
-uint64_t *fuco_parse_integer(char *lexeme);
-
-size_t fuco_filebuf_read(fuco_filebuf_t *filebuf, FILE *file);
+uint64_t *fuco_parse_integer(char const *start, size_t len);
 
 void fuco_lexer_init(fuco_lexer_t *lexer);
 
@@ -55,13 +49,20 @@ void fuco_lexer_add_job(fuco_lexer_t *lexer, char *filename);
 
 int fuco_lexer_open_next_file(fuco_lexer_t *lexer);
 
-void fuco_lexer_next_char(fuco_lexer_t *lexer);
-
 void fuco_lexer_skip_nontokens(fuco_lexer_t *lexer);
 
-void fuco_lexer_append_token(fuco_lexer_t *lexer, fuco_tokentype_t type, 
-                             char *lexeme, void *data);
+void fuco_lexer_get_source(fuco_lexer_t *lexer, char *start, 
+                           fuco_textsource_t *source);
+
+void fuco_lexer_set_token(fuco_lexer_t *lexer, fuco_token_t *token, 
+                          fuco_tokentype_t type, char *start, char *lexeme, 
+                          void *data);
+
+/* Lexes a single token, opening queued files as needed. Produces 
+   FUCO_TOKEN_END_OF_SOURCE once all files are consumed */
+int fuco_lexer_next_token(fuco_lexer_t *lexer, fuco_token_t *token);
 
+/* Materializes all tokens in the lexer's token list */
 fuco_tstream_t fuco_lexer_lex(fuco_lexer_t *lexer);
 
 #endif
@@ -2,7 +2,9 @@
 #define FUCO_PARSER_H
 
 #include "tokenlist.h"
+#include "tokenring.h"
 #include "tree.h"
+#include "threadpool.h"
 
 typedef enum {
     FUCO_ASSOCIATIVE_LEFT,
@@ -11,31 +13,87 @@ typedef enum {
 
 #define FUCO_MAX_OPERATORS_PER_LEVEL 4
 
+#define FUCO_INSTR_OPCODES_N 13
+
+/* Nested blocks and expressions recurse natively, each nesting level is 
+   budgeted this much stack, several times what it takes */
+#define FUCO_PARSER_DEPTH_STACK 1024
+
+/* Nesting limit on a worker stack */
+#define FUCO_PARSER_MAX_DEPTH \
+    (FUCO_THREADPOOL_STACK_SIZE / FUCO_PARSER_DEPTH_STACK)
+
 typedef struct {
     fuco_operator_associativity_t associativity;
     fuco_tokentype_t operators[FUCO_MAX_OPERATORS_PER_LEVEL];
 } fuco_operator_specification_t;
 
+/* Binding powers derived from fuco_operator_specs, 0 for non-operators. The 
+   operator binds to its right operand with the right power */
+typedef struct {
+    uint8_t left;
+    uint8_t right;
+} fuco_operator_binding_t;
+
 typedef struct {
-    fuco_tstream_t tstream;
-    fuco_map_t instrs;
+    fuco_tstream_t tstream; /* Current token */
+    fuco_tokenring_t *ring; /* Streaming source, NULL for a full tstream */
+    /* Copies of the tokens referenced by nodes when streaming, which grow 
+       with the input like the tree does */
+    fuco_tokenarena_t pinned;
+    fuco_token_t *pinned_current;
+    size_t depth;
+    size_t max_depth; /* Nesting limit for the stack the parser runs on */
+    size_t n_nodes; /* Created so far, for the time report */
 } fuco_parser_t;
 
 extern fuco_operator_specification_t fuco_operator_specs[];
 
+extern fuco_operator_binding_t fuco_operator_bindings[FUCO_N_TOKENTYPES];
+
+extern pthread_once_t fuco_operator_bindings_once;
+
+/* Opcodes available to %instr bodies */
+extern fuco_opcode_t fuco_instr_opcodes[FUCO_INSTR_OPCODES_N];
+
+/* Fills fuco_operator_bindings, run once through fuco_parser_init */
+void fuco_operator_bindings_setup(void);
+
 void fuco_parser_init(fuco_parser_t *parser);
 
 void fuco_parser_destruct(fuco_parser_t *parser);
 
-void fuco_parser_setup_instrs(fuco_parser_t *parser);
+void fuco_parser_set_ring(fuco_parser_t *parser, fuco_tokenring_t *ring);
 
-fuco_token_t *fuco_parser_advance(fuco_parser_t *parser);
+/* Limits nesting to what fits in a stack of stack_size bytes */
+void fuco_parser_set_stack(fuco_parser_t *parser, size_t stack_size);
+
+/* Returns a pointer to the current token that stays valid after advancing. 
+   When streaming, the token is copied into the arena of the parser */
+fuco_token_t *fuco_parser_pin(fuco_parser_t *parser);
+
+void fuco_parser_advance(fuco_parser_t *parser);
+
+/* Enters a nesting level, false after reporting if the limit is exceeded */
+bool fuco_parser_enter(fuco_parser_t *parser);
+
+void fuco_parser_leave(fuco_parser_t *parser);
+
+/* Node constructors of the parser, which count the nodes created */
+fuco_node_t *fuco_parser_node_new(fuco_parser_t *parser, 
+                                  fuco_nodetype_t type);
+
+fuco_node_t *fuco_parser_variadic_new(fuco_parser_t *parser, 
+                                      fuco_nodetype_t type, 
+                                      size_t *allocated);
 
 void fuco_parser_move(fuco_parser_t *parser, fuco_node_t *node);
 
 bool fuco_parser_accept(fuco_parser_t *parser, fuco_tokentype_t type, 
                         fuco_node_t *node);
 
+void fuco_parser_unexpected(fuco_parser_t *parser, char *expected);
+
 bool fuco_parser_expect(fuco_parser_t *parser, fuco_tokentype_t type, 
                         fuco_node_t *node);
 
@@ -61,11 +119,8 @@ fuco_node_t *fuco_parse_while(fuco_parser_t *parser);
 
 fuco_node_t *fuco_parse_expression(fuco_parser_t *parser);
 
-fuco_node_t *fuco_parse_operator(fuco_parser_t *parser, size_t level);
-
-fuco_node_t *fuco_parse_operator_left(fuco_parser_t *parser, size_t level);
-
-fuco_node_t *fuco_parse_operator_right(fuco_parser_t *parser, size_t level);
+/* Parses operators binding at least as strongly as min_binding */
+fuco_node_t *fuco_parse_operator(fuco_parser_t *parser, uint8_t min_binding);
 
 fuco_node_t *fuco_parse_value(fuco_parser_t *parser);
 
@@ -0,0 +1,40 @@
+#ifndef FUCO_PERF_H
+#define FUCO_PERF_H
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    FUCO_PERF_CYCLES,
+    FUCO_PERF_INSTRUCTIONS,
+    FUCO_PERF_BRANCH_MISSES,
+    FUCO_PERF_L1D_MISSES,
+    FUCO_PERF_L1I_MISSES,
+    FUCO_N_PERF_EVENTS
+} fuco_perf_event_t;
+
+/* Hardware counters in user space of the calling thread and of the threads 
+   it creates after opening them, opened through perf_event_open on Linux. 
+   Reads include threads still running and those that have exited. Events 
+   the kernel or processor does not support are left closed with a 
+   descriptor of -1 */
+typedef struct {
+    int fds[FUCO_N_PERF_EVENTS];
+} fuco_perf_t;
+
+char const *fuco_perf_event_string(fuco_perf_event_t event);
+
+/* Returns the number of events opened, 0 where counters are unavailable */
+size_t fuco_perf_open(fuco_perf_t *perf);
+
+void fuco_perf_close(fuco_perf_t *perf);
+
+bool fuco_perf_available(fuco_perf_t *perf, fuco_perf_event_t event);
+
+/* Reads running totals, unavailable events read as 0 */
+void fuco_perf_read(fuco_perf_t *perf, uint64_t counts[FUCO_N_PERF_EVENTS]);
+
+#endif
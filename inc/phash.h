@@ -0,0 +1,35 @@
+#ifndef FUCO_PHASH_H
+#define FUCO_PHASH_H
+
+#include "token.h"
+#include "instruction.h"
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+    char const *key;
+    uint32_t value;
+} fuco_phash_entry_t;
+
+/* Minimal perfect hash over a fixed key set: every key maps to a distinct 
+   slot of entries[size]. Seeds are searched by tools/phashgen at build time */
+typedef struct {
+    fuco_phash_entry_t const *entries;
+    uint32_t size;
+    uint32_t seed;
+} fuco_phash_table_t;
+
+uint32_t fuco_phash(uint32_t seed, char const *str, size_t len);
+
+/* Returns the entry for str if it is in the key set, NULL otherwise */
+fuco_phash_entry_t const *fuco_phash_lookup(fuco_phash_table_t const *table, 
+                                            char const *str, size_t len);
+
+/* Returns FUCO_TOKEN_EMPTY if not found */
+fuco_tokentype_t fuco_phash_tokentype(char const *str, size_t len, 
+                                      fuco_tokenkind_t kind);
+
+/* Returns FUCO_OPCODES_N if not found */
+fuco_opcode_t fuco_phash_instr(char const *str, size_t len);
+
+#endif
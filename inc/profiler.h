@@ -0,0 +1,57 @@
+#ifndef FUCO_PROFILER_H
+#define FUCO_PROFILER_H
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ir.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#define FUCO_PROFILER_INTERVAL_US 1000
+
+/* Innermost frames kept per sample, deeper stacks are truncated */
+#define FUCO_PROFILER_MAX_DEPTH 256
+
+/* Set in the depth of truncated samples */
+#define FUCO_PROFILER_TRUNCATED ((uint64_t)1 << 63)
+
+#define FUCO_PROFILER_INIT_SIZE 4096
+
+/* Set by the SIGPROF handler, the interpreter takes a sample at the next
+   instruction so the stack is consistent while it is walked */
+extern volatile sig_atomic_t fuco_profiler_pending;
+
+/* Samples are stored back to back as a depth followed by that many
+   addresses, innermost first */
+struct fuco_profiler_t {
+    uint64_t *data;
+    size_t size;
+    size_t cap;
+    size_t n_samples;
+    struct sigaction old_action;
+    struct itimerval old_timer;
+};
+
+void fuco_profiler_init(fuco_profiler_t *profiler);
+
+void fuco_profiler_destruct(fuco_profiler_t *profiler);
+
+void fuco_profiler_handle(int signal);
+
+/* Installs the handler and starts the CPU time interval timer */
+int fuco_profiler_start(fuco_profiler_t *profiler);
+
+void fuco_profiler_stop(fuco_profiler_t *profiler);
+
+/* Records ip and the return addresses in the saved bp chain */
+void fuco_profiler_sample(fuco_profiler_t *profiler, uint64_t ip,
+                          uint64_t bp, char const *stack);
+
+/* Writes one line per distinct stack in folded format: frames from the
+   root separated by ';', followed by the number of samples */
+int fuco_profiler_write_folded(fuco_profiler_t *profiler, fuco_ir_t *ir,
+                               FILE *file);
+
+#endif
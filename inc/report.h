@@ -0,0 +1,76 @@
+#ifndef FUCO_REPORT_H
+#define FUCO_REPORT_H
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "perf.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Lexing streams into parsing, so both are measured as one phase */
+typedef enum {
+    FUCO_PHASE_PARSE,
+    FUCO_PHASE_DECLARE,
+    FUCO_PHASE_GENERATE,
+    FUCO_PHASE_ASSEMBLE,
+    FUCO_PHASE_EXECUTE,
+    FUCO_N_PHASES
+} fuco_phase_t;
+
+typedef struct {
+    double seconds; /* Wall clock, phases may run on several workers */
+    uint64_t allocated; /* Bytes requested from the allocator */
+    int64_t heap_delta; /* Growth of bytes in use on the heap */
+    uint64_t counts[FUCO_N_PERF_EVENTS]; /* Summed over all workers */
+} fuco_phase_report_t;
+
+typedef struct {
+    fuco_phase_report_t phases[FUCO_N_PHASES];
+    double start;
+    size_t start_heap;
+    uint64_t start_allocated;
+    uint64_t start_counts[FUCO_N_PERF_EVENTS];
+    fuco_perf_t *perf; /* Hardware counters are reported if not NULL */
+    size_t n_tokens;
+    size_t n_nodes;
+    size_t n_symbols;
+    size_t n_ir_units;
+    size_t n_bytecode_words;
+    size_t heap; /* Bytes in use after the last phase */
+    size_t peak_rss; /* Bytes */
+} fuco_report_t;
+
+/* Set once a report begins, from then on every thread adds the bytes it 
+   requests through malloc, calloc and realloc to fuco_allocated */
+extern bool fuco_allocations_counted;
+
+extern uint64_t fuco_allocated;
+
+char const *fuco_phase_string(fuco_phase_t phase);
+
+/* Returns 0 where allocations are not counted */
+uint64_t fuco_allocated_bytes(void);
+
+double fuco_clock_now(void);
+
+/* Returns 0 where the allocator does not report usage */
+size_t fuco_heap_in_use(void);
+
+size_t fuco_peak_rss(void);
+
+void fuco_report_init(fuco_report_t *report);
+
+/* No-ops if report is NULL, so the compiler can call them unconditionally */
+void fuco_report_begin(fuco_report_t *report);
+
+void fuco_report_end(fuco_report_t *report, fuco_phase_t phase);
+
+void fuco_report_write_counters(fuco_report_t *report, FILE *file);
+
+void fuco_report_write(fuco_report_t *report, FILE *file);
+
+void fuco_report_write_json(fuco_report_t *report, FILE *file);
+
+#endif
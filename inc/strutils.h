@@ -7,12 +7,22 @@
 
 #define FUCO_STRBUF_INIT_SIZE 256
 
+#define FUCO_STRTABLE_INIT_SIZE 64
+
 typedef struct {
     char *data;
     size_t len;
     size_t cap;
 } fuco_strbuf_t;
 
+/* Interns string slices: each distinct spelling is stored once, NUL-terminated 
+   and owned by the table. Open addressing, load factor at most 1/2 */
+typedef struct {
+    char **strs;
+    size_t size;
+    size_t cap;
+} fuco_strtable_t;
+
 void fuco_strbuf_init(fuco_strbuf_t *buf);
 
 void fuco_strbuf_clear(fuco_strbuf_t *buf);
@@ -33,4 +43,15 @@ fuco_hashvalue_t fuco_string_hash(void *data);
 
 bool fuco_string_equal(void *left, void *right);
 
+fuco_hashvalue_t fuco_slice_hash(char const *str, size_t len);
+
+void fuco_strtable_init(fuco_strtable_t *table);
+
+void fuco_strtable_destruct(fuco_strtable_t *table);
+
+void fuco_strtable_rehash(fuco_strtable_t *table);
+
+char *fuco_strtable_intern(fuco_strtable_t *table, char const *str, 
+                           size_t len);
+
 #endif
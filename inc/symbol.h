@@ -4,6 +4,7 @@
 #include "token.h"
 #include "map.h"
 #include "ir.h"
+#include "types.h"
 #include <stdint.h>
 #include <stdio.h>
 
@@ -41,6 +42,8 @@ typedef struct fuco_symbol_t {
     fuco_symbolid_t id;
     fuco_symboltype_t type;
     fuco_node_t *def;
+    /* For TYPE: the named type, for FUNCTION: its signature */
+    fuco_typeid_t typeid;
     void *value;
     /* IR generated object */
     size_t obj;
@@ -56,19 +59,39 @@ typedef struct fuco_scope_t {
     struct fuco_scope_t **equivalent;
 } fuco_scope_t;
 
-#define FUCO_SYMBOL_CHUNK_SIZE 512
+/* Dense matrix of implicit conversions between named types, indexed by 
+   [from * size + to] on their index among named types. Function signatures 
+   are interned as types too, so raw type ids would make it quadratic in 
+   the number of distinct signatures */
+typedef struct {
+    fuco_typetable_t *types;
+    fuco_symbol_t **direct;
+    /* First conversion of a shortest conversion chain, NULL if unreachable */
+    fuco_symbol_t **first;
+    size_t size;
+} fuco_conversion_table_t;
+
+/* Must be a power of two: ids are split into chunk index and offset */
+#define FUCO_SYMBOL_CHUNK_BITS 9
+
+#define FUCO_SYMBOL_CHUNK_SIZE ((size_t)1 << FUCO_SYMBOL_CHUNK_BITS)
 
-typedef struct fuco_symbol_chunk_t {
+#define FUCO_SYMBOL_DIRECTORY_INIT_SIZE 16
+
+typedef struct {
     fuco_symbol_t data[FUCO_SYMBOL_CHUNK_SIZE];
     size_t size;
-    struct fuco_symbol_chunk_t *next;
 } fuco_symbol_chunk_t;
 
 struct fuco_symboltable_t {
-    /* Insertion at front: [back, ..., front] */
-    fuco_symbol_chunk_t *back;
-    fuco_symbol_chunk_t *front;
+    /* Directory of chunks, all full except the last. Chunks are never moved 
+       so symbol pointers stay valid when the directory grows. */
+    fuco_symbol_chunk_t **chunks;
+    size_t n_chunks;
+    size_t cap_chunks;
     size_t size;
+    fuco_typetable_t types;
+    fuco_conversion_table_t conversions;
     struct {
         fuco_node_t *root;
         size_t allocated;
@@ -93,13 +116,37 @@ fuco_symbol_t *fuco_scope_lookup(fuco_scope_t *scope, char *ident,
 fuco_symbol_t *fuco_scope_lookup_token(fuco_scope_t *scope, 
                                        fuco_token_t *token);
 
-fuco_symbol_t *fuco_scope_lookup_conversion(fuco_scope_t *scope, 
-                                            fuco_node_t *from, 
-                                            fuco_node_t *to);
-                                            
 fuco_symbol_t *fuco_scope_insert(fuco_scope_t *scope, 
                                  fuco_token_t *token, fuco_symbol_t *symbol);
 
+fuco_typeid_t fuco_conversion_get_from(fuco_symbol_t *conv);
+
+fuco_typeid_t fuco_conversion_get_to(fuco_symbol_t *conv);
+
+void fuco_conversion_table_init(fuco_conversion_table_t *convs);
+
+void fuco_conversion_table_destruct(fuco_conversion_table_t *convs);
+
+/* Index of a named type into the matrices, false for any other type */
+bool fuco_conversion_table_index(fuco_conversion_table_t *convs, 
+                                 fuco_typeid_t id, size_t *index);
+
+/* Builds the direct and chained conversion matrices from all conversion 
+   overloads visible from scope. Requires the functions to be gathered. */
+void fuco_conversion_table_setup(fuco_conversion_table_t *convs, 
+                                 fuco_symboltable_t *table, 
+                                 fuco_scope_t *scope);
+
+fuco_symbol_t *fuco_conversion_table_lookup(fuco_conversion_table_t *convs, 
+                                            fuco_typeid_t from, 
+                                            fuco_typeid_t to);
+
+/* Writes the shortest chain of conversions from -> to into chain (at most max 
+   entries). Returns the length of the chain, or 0 if there is none. */
+size_t fuco_conversion_table_chain(fuco_conversion_table_t *convs, 
+                                   fuco_typeid_t from, fuco_typeid_t to, 
+                                   fuco_symbol_t **chain, size_t max);
+
 fuco_symbol_chunk_t *fuco_symbol_chunk_new();
 
 void fuco_symboltable_init(fuco_symboltable_t *table);
@@ -126,4 +173,8 @@ fuco_symbol_t *fuco_symboltable_lookup(fuco_symboltable_t *table,
 fuco_node_t *fuco_symboltable_get_type(fuco_symboltable_t *table, 
                                        fuco_symbolid_t id);
 
+fuco_symbol_t *fuco_symboltable_lookup_conversion(fuco_symboltable_t *table, 
+                                                  fuco_node_t *from, 
+                                                  fuco_node_t *to);
+
 #endif
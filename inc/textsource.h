@@ -3,17 +3,64 @@
 
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
 
+#define FUCO_SOURCEFILE_NONE 0 /* Synthetic and builtin tokens */
+
+#define FUCO_SOURCEFILES_INIT_SIZE 4
+
+/* Source file mapped read-only while open. Line starts are only indexed once 
+   a location in the file is resolved to row and column */
 typedef struct {
     char *filename;
-    size_t row;
-    size_t col;
+    char *data;
+    size_t size;
+    uint32_t *lines;
+    size_t n_lines;
+} fuco_sourcefile_t;
+
+typedef struct {
+    fuco_sourcefile_t **files;
+    size_t size;
+    size_t cap;
+    pthread_mutex_t lock;
+} fuco_sourcefiles_t;
+
+typedef struct {
+    uint32_t file;
+    uint32_t offset;
 } fuco_textsource_t;
 
-void fuco_textsource_init(fuco_textsource_t *source, char *filename);
+/* Registry of all files opened during compilation, indexed by file id. Ids 
+   and file pointers stay valid after a file is closed. Safe to use from 
+   multiple threads */
+extern fuco_sourcefiles_t fuco_sourcefiles;
 
-void fuco_textsource_write(fuco_textsource_t *source, FILE *file);
+int fuco_sourcefile_map(fuco_sourcefile_t *file, char *filename);
+
+void fuco_sourcefile_unmap(fuco_sourcefile_t *file);
 
-void fuco_textsource_next_char(fuco_textsource_t *source, int c);
+void fuco_sourcefile_index_lines(fuco_sourcefile_t *file);
+
+/* Returns FUCO_SOURCEFILE_NONE on error */
+uint32_t fuco_sourcefiles_open(char *filename);
+
+void fuco_sourcefiles_close(uint32_t id);
+
+/* Unmaps and frees every file and empties the registry, ids handed out 
+   before are invalid afterwards */
+void fuco_sourcefiles_destruct(void);
+
+fuco_sourcefile_t *fuco_sourcefiles_get(uint32_t id);
+
+void fuco_textsource_init(fuco_textsource_t *source, uint32_t file, 
+                          uint32_t offset);
+
+/* Returns 1 if the position is unknown */
+int fuco_textsource_get_position(fuco_textsource_t *source, 
+                                 size_t *row, size_t *col);
+
+void fuco_textsource_write(fuco_textsource_t *source, FILE *file);
 
 #endif
@@ -0,0 +1,53 @@
+#ifndef FUCO_THREADPOOL_H
+#define FUCO_THREADPOOL_H
+
+#include "queue.h"
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/* Workers get large stacks for the recursive descent parser */
+#define FUCO_THREADPOOL_STACK_SIZE ((size_t)64 << 20)
+
+typedef void(*fuco_job_func_t)(void *);
+
+typedef struct {
+    fuco_job_func_t func;
+    void *arg;
+} fuco_job_t;
+
+/* Fixed set of workers running submitted jobs in submission order. Without 
+   workers, jobs run inline on submission */
+typedef struct {
+    pthread_t *threads;
+    size_t n_threads;
+    fuco_queue_t jobs;
+    size_t pending; /* Submitted but not yet finished */
+    bool stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t has_jobs;
+    pthread_cond_t idle;
+} fuco_threadpool_t;
+
+/* Number of online processors, at least 1 */
+size_t fuco_threadpool_default_size(void);
+
+/* Starts up to n_threads workers, fewer if thread creation fails */
+void fuco_threadpool_init(fuco_threadpool_t *pool, size_t n_threads);
+
+/* Stack available to jobs, the limit of the calling thread when they run 
+   inline */
+size_t fuco_threadpool_stack_size(fuco_threadpool_t *pool);
+
+/* Waits for pending jobs and joins all workers */
+void fuco_threadpool_destruct(fuco_threadpool_t *pool);
+
+void fuco_threadpool_submit(fuco_threadpool_t *pool, fuco_job_func_t func, 
+                            void *arg);
+
+/* Blocks until all submitted jobs have finished */
+void fuco_threadpool_wait(fuco_threadpool_t *pool);
+
+void *fuco_threadpool_worker(void *arg);
+
+#endif
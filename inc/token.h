@@ -3,6 +3,7 @@
 
 #include "textsource.h"
 #include <stdio.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 typedef enum {
@@ -19,6 +20,7 @@ typedef enum {
     FUCO_TOKEN_START_OF_SOURCE,
     FUCO_TOKEN_END_OF_FILE,
     FUCO_TOKEN_END_OF_SOURCE, /* Final token in tokenlist */
+    FUCO_TOKEN_ERROR, /* Lexer failed, error already reported */
 
     FUCO_TOKEN_INTEGER,
     FUCO_TOKEN_IDENTIFIER,
@@ -63,9 +65,10 @@ typedef enum {
 } fuco_tokentype_t;
 
 typedef struct {
-    char *lexeme;
+    char *lexeme; /* Interned spelling of literals, owned by the lexer */
     void *data;
-    fuco_textsource_t source;
+    fuco_textsource_t source; /* Lexeme starts at source.offset */
+    uint32_t length;
     fuco_tokentype_t type;
 } fuco_token_t;
 
@@ -86,6 +89,9 @@ char *fuco_tokentype_string(fuco_tokentype_t type);
 fuco_tokentype_t fuco_tokentype_lookup_string(char *lexeme, 
                                               fuco_tokenkind_t kind);
 
+fuco_tokentype_t fuco_tokentype_lookup_slice(char const *start, size_t len, 
+                                             fuco_tokenkind_t kind);
+
 void fuco_token_init(fuco_token_t *token);
 
 void fuco_token_destruct(fuco_token_t *token);
@@ -94,7 +100,4 @@ void fuco_token_write(fuco_token_t *token, FILE *file);
 
 char *fuco_token_string(fuco_token_t *token);
 
-/* Static rotation: max. 16 uses at once */
-char *fuco_token_static_string(fuco_token_t *token);
-
 #endif
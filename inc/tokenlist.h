@@ -17,6 +17,21 @@ typedef struct {
     size_t cap;
 } fuco_tokenlist_t;
 
+#define FUCO_TOKENARENA_CHUNK_SIZE 256
+
+typedef struct fuco_tokenchunk_t {
+    struct fuco_tokenchunk_t *next;
+    size_t size;
+    fuco_token_t tokens[FUCO_TOKENARENA_CHUNK_SIZE];
+} fuco_tokenchunk_t;
+
+/* Stable storage for tokens that outlive a streaming token buffer, e.g. 
+   tokens referenced by nodes. Tokens are never moved */
+typedef struct {
+    fuco_tokenchunk_t *head;
+    size_t size;
+} fuco_tokenarena_t;
+
 #define FUCO_PARTIAL_TSTREAM(list) (fuco_tstream_t)((list)->tokens)
 
 void fuco_tokenlist_init(fuco_tokenlist_t *list);
@@ -34,4 +49,12 @@ fuco_token_t *fuco_tokenlist_append(fuco_tokenlist_t *list);
 
 fuco_tstream_t fuco_tokenlist_terminate(fuco_tokenlist_t *list);
 
+void fuco_tokenarena_init(fuco_tokenarena_t *arena);
+
+void fuco_tokenarena_destruct(fuco_tokenarena_t *arena);
+
+/* Moves token into the arena, including ownership of its data */
+fuco_token_t *fuco_tokenarena_add(fuco_tokenarena_t *arena, 
+                                  fuco_token_t *token);
+
 #endif
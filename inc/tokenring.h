@@ -0,0 +1,53 @@
+#ifndef FUCO_TOKENRING_H
+#define FUCO_TOKENRING_H
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "lexer.h"
+#include <stdbool.h>
+#include <pthread.h>
+
+#define FUCO_TOKENRING_SIZE 256 /* Power of two */
+
+/* Consumer publishes released slots in batches of this size */
+#define FUCO_TOKENRING_BATCH (FUCO_TOKENRING_SIZE / 4)
+
+/* Bounded token buffer between lexer and parser. Filled on demand by the 
+   consumer, or by the lexer running on its own thread. Slots in 
+   [head, tail) hold lexed tokens, tokens that must outlive their slot are 
+   moved out with fuco_tokenarena_add. Counters increase monotonically and 
+   are masked on access */
+typedef struct {
+    fuco_token_t tokens[FUCO_TOKENRING_SIZE];
+    fuco_lexer_t *lexer;
+    size_t head; /* Owned by consumer */
+    size_t avail; /* Consumer's view of tail */
+    size_t tail; /* Owned by producer */
+    size_t shared_head; /* Published under lock when threaded */
+    size_t shared_tail;
+    bool done; /* End of source or error produced */
+    bool closed; /* Consumer stopped early */
+    bool threaded;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} fuco_tokenring_t;
+
+int fuco_tokenring_init(fuco_tokenring_t *ring, fuco_lexer_t *lexer, 
+                        bool threaded);
+
+void fuco_tokenring_destruct(fuco_tokenring_t *ring);
+
+/* Lexes into free slots from tail up to limit. A lexer error produces a 
+   FUCO_TOKEN_ERROR token. Returns the new tail */
+size_t fuco_tokenring_produce(fuco_tokenring_t *ring, size_t limit);
+
+void *fuco_tokenring_thread(void *arg);
+
+/* Returns the token at head, waiting for or lexing it if necessary */
+fuco_token_t *fuco_tokenring_peek(fuco_tokenring_t *ring);
+
+void fuco_tokenring_release(fuco_tokenring_t *ring);
+
+#endif
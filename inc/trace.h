@@ -0,0 +1,53 @@
+#ifndef FUCO_TRACE_H
+#define FUCO_TRACE_H
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ir.h"
+#include <stdio.h>
+#include <stdint.h>
+
+/* Entries kept, a power of two */
+#define FUCO_TRACE_SIZE 4096
+
+/* "FUCOTRC1" read as a little endian word */
+#define FUCO_TRACE_MAGIC 0x31435254434F4355ULL
+
+typedef struct {
+    uint64_t ip; /* Address of the call, return or taken branch */
+    uint64_t sp; /* Before the transfer, branches have popped their test */
+} fuco_trace_entry_t;
+
+/* Ring of the last control transfers. Its memory is also the dump format, 
+   so a fatal signal handler can write it with a single write() */
+struct fuco_trace_t {
+    uint64_t magic;
+    uint64_t size;
+    uint64_t head; /* Entries recorded in total */
+    fuco_trace_entry_t entries[FUCO_TRACE_SIZE];
+};
+
+void fuco_trace_init(fuco_trace_t *trace);
+
+void fuco_trace_record(fuco_trace_t *trace, uint64_t ip, uint64_t sp);
+
+/* Dumps trace to fd when the interpreter crashes and on SIGUSR1, until 
+   uninstalled. fd is rewritten from the start on every dump */
+int fuco_trace_install(fuco_trace_t *trace, int fd);
+
+void fuco_trace_uninstall(void);
+
+void fuco_trace_handle(int signal);
+
+/* Async-signal-safe */
+int fuco_trace_dump(fuco_trace_t *trace, int fd);
+
+/* Reads a dump, returns 1 if it is not one */
+int fuco_trace_read(fuco_trace_t *trace, FILE *file);
+
+/* Writes entries oldest first with the function and instruction at each 
+   address, bytecode and ir must be compiled from the traced sources */
+void fuco_trace_write(fuco_trace_t *trace, fuco_bytecode_t *bytecode,
+                      fuco_ir_t *ir, FILE *file);
+
+#endif
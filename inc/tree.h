@@ -21,6 +21,8 @@ typedef enum {
     FUCO_NODE_IF_ELSE,
     FUCO_NODE_WHILE,
     FUCO_NODE_TYPE_IDENTIFIER,
+
+    FUCO_NODETYPES_N
 } fuco_nodetype_t;
 
 /* Defines position and counts of child nodes. Each type starts with 
@@ -76,6 +78,7 @@ struct fuco_node_t {
     union {
         struct fuco_node_t *datatype;
         fuco_scope_t *scope;
+        fuco_typeid_t typeid;
     } data;
     fuco_opcode_t opcode;
     size_t count;
@@ -84,6 +87,66 @@ struct fuco_node_t {
 
 extern fuco_node_t fuco_node_empty;
 
+#define FUCO_WALKER_INIT_SIZE 64
+
+/* Frame of an explicit traversal stack. step counts the visits to node so 
+   far; scope and ctx are inherited from the parent frame when pushed */
+typedef struct {
+    fuco_node_t *node;
+    size_t step;
+    fuco_scope_t *scope;
+    fuco_node_t *ctx;
+    uint64_t state[2]; /* Kept across visits of the same node */
+} fuco_walk_frame_t;
+
+typedef struct fuco_walker_t fuco_walker_t;
+
+/* Called on every visit to the top frame. Returns the next child to 
+   descend into, or NULL when done with the node. Errors are reported by 
+   setting walker->error, which stops the traversal */
+typedef fuco_node_t *(*fuco_walk_func_t)(fuco_walker_t *walker, 
+                                         fuco_walk_frame_t *frame);
+
+/* Traverses trees without native recursion, so depth is bounded by memory 
+   rather than by the C stack. Shallow trees stay within the initial frames, 
+   which also means a walker cannot be copied */
+struct fuco_walker_t {
+    fuco_walk_frame_t initial[FUCO_WALKER_INIT_SIZE];
+    fuco_walk_frame_t *frames;
+    size_t size;
+    size_t cap;
+    fuco_walk_func_t visit;
+    void *data; /* Pass state */
+    int error;
+};
+
+/* Callback of a fused preorder pass, see fuco_node_run_passes. Scopes set 
+   in frame->scope are inherited by the children */
+typedef int (*fuco_node_pass_t)(fuco_walk_frame_t *frame, void *data);
+
+/* Number of children of a node a traversal descends into */
+typedef size_t (*fuco_walk_size_t)(fuco_node_t *node);
+
+/* Pass state of fused preorder passes */
+typedef struct {
+    fuco_walk_size_t size;
+    fuco_node_pass_t *passes;
+    size_t n_passes;
+    void *data;
+} fuco_pass_walk_t;
+
+/* Pass state of IR generation */
+typedef struct {
+    fuco_ir_t *ir;
+    size_t obj;
+} fuco_ir_walk_t;
+
+/* Pass state of fused analysis */
+typedef struct {
+    fuco_symboltable_t *table;
+    fuco_ir_walk_t ir;
+} fuco_analysis_t;
+
 fuco_node_layout_t fuco_nodetype_get_layout(fuco_nodetype_t type);
 
 char *fuco_nodetype_get_label(fuco_nodetype_t type);
@@ -105,8 +168,25 @@ fuco_node_t *fuco_node_variadic_transform(fuco_node_t *node,
                                           fuco_nodetype_t type, 
                                           size_t *allocated);
 
+void fuco_walker_init(fuco_walker_t *walker, fuco_walk_func_t visit, 
+                      void *data);
+
+void fuco_walker_destruct(fuco_walker_t *walker);
+
+fuco_walk_frame_t *fuco_walker_push(fuco_walker_t *walker, fuco_node_t *node);
+
+/* Visits the tree rooted at node until done or an error is set */
+int fuco_walker_run(fuco_walker_t *walker, fuco_node_t *node, 
+                    fuco_scope_t *scope, fuco_node_t *ctx);
+
+/* Returns the index of the child the frame is currently in */
+size_t fuco_walk_frame_child(fuco_walk_frame_t *frame);
+
 fuco_node_t *fuco_node_set_count(fuco_node_t *node, size_t count);
 
+fuco_node_t *fuco_node_free_visit(fuco_walker_t *walker, 
+                                  fuco_walk_frame_t *frame);
+
 void fuco_node_free(fuco_node_t *node);
 
 /* May realloc, result should not be discarded */
@@ -118,6 +198,9 @@ void fuco_node_set_child(fuco_node_t *node, fuco_node_t *child,
 
 void fuco_node_write(fuco_node_t *node, FILE *file);
 
+fuco_node_t *fuco_node_pretty_write_visit(fuco_walker_t *walker, 
+                                          fuco_walk_frame_t *frame);
+
 void fuco_node_pretty_write(fuco_node_t *node, FILE *file);
 
 void fuco_node_unparse_write(fuco_node_t *node, FILE *file);
@@ -128,47 +211,83 @@ bool fuco_node_has_type(fuco_node_t *node);
 
 bool fuco_node_type_equal(fuco_node_t *node, fuco_node_t *other);
 
-void fuco_node_setup_scopes(fuco_node_t *node, fuco_scope_t *scope);
+fuco_node_t *fuco_node_run_passes_visit(fuco_walker_t *walker, 
+                                        fuco_walk_frame_t *frame);
 
-fuco_scope_t *fuco_node_get_scope(fuco_node_t *node, fuco_scope_t *outer);
+/* Runs all passes in a single preorder traversal, descending into the first 
+   size(node) children: every node is handed to each pass in turn before its 
+   children. Stops at the first pass returning nonzero */
+int fuco_node_run_passes(fuco_node_t *node, fuco_walk_size_t size, 
+                         fuco_node_pass_t *passes, size_t n_passes, 
+                         void *data);
 
-int fuco_node_gather_datatypes(fuco_node_t *node, fuco_symboltable_t *table, 
-                                fuco_scope_t *outer);
+/* Creates the scope of a scoped node, declaring builtins in the global one */
+int fuco_node_setup_scope(fuco_walk_frame_t *frame, void *data);
+
+fuco_scope_t *fuco_node_get_scope(fuco_node_t *node, fuco_scope_t *outer);
 
 int fuco_node_resolve_type(fuco_node_t *node, fuco_symboltable_t *table, 
                            fuco_scope_t *outer);
 
-int fuco_node_gather_functions(fuco_node_t *node, fuco_symboltable_t *table, 
-                                fuco_scope_t *outer);
+int fuco_node_gather_function(fuco_walk_frame_t *frame, void *data);
 
-int fuco_node_coerce_type(fuco_node_t **pnode, fuco_node_t *type, 
-                          fuco_scope_t *scope);
+/* Declarations only appear at file level, and a function declares its 
+   parameters itself, so function bodies are not descended into */
+size_t fuco_node_declare_walk_size(fuco_node_t *node);
 
-int fuco_node_resolve_local_propagate(fuco_node_t *node, 
-                                      fuco_symboltable_t *table, 
-                                      fuco_scope_t *scope, fuco_node_t *ctx);
+/* Declares all global symbols in one sweep over the declarations, running 
+   the scope and function passes above as fused callbacks */
+int fuco_node_gather_globals(fuco_node_t *root, fuco_symboltable_t *table);
 
-int fuco_node_resolve_local_function(fuco_node_t *node, 
-                                     fuco_symboltable_t *table, 
-                                     fuco_scope_t *scope);
+/* Interns the function type of a FUNCTION node with resolved types */
+fuco_typeid_t fuco_node_signature(fuco_node_t *node, fuco_typetable_t *types);
 
+int fuco_node_coerce_type(fuco_node_t **pnode, fuco_node_t *type, 
+                          fuco_symboltable_t *table);
+
+/* Resolves a call after its arguments */
 int fuco_node_resolve_local_call(fuco_node_t *node, fuco_symboltable_t *table, 
+                                 fuco_scope_t *scope);
+
+int fuco_node_resolve_instr_arity(fuco_node_t *node);
+
+/* Resolves node once its children are resolved */
+int fuco_node_resolve_local_node(fuco_node_t *node, fuco_symboltable_t *table, 
                                  fuco_scope_t *scope, fuco_node_t *ctx);
 
-int fuco_node_resolve_local(fuco_node_t *node, fuco_symboltable_t *table, 
-                            fuco_scope_t *outer, fuco_node_t *ctx);
+/* Sets up the scope and context the children of a node are resolved in */
+void fuco_node_resolve_local_enter(fuco_walk_frame_t *frame);
+
+/* Adds an empty object for every function, in definition order */
+void fuco_node_create_objects(fuco_node_t *node, fuco_ir_t *ir);
+
+fuco_node_t *fuco_node_generate_ir_if_else(fuco_walk_frame_t *frame, 
+                                           fuco_ir_t *ir, size_t obj);
+
+fuco_node_t *fuco_node_generate_ir_while(fuco_walk_frame_t *frame, 
+                                         fuco_ir_t *ir, size_t obj);
+
+/* Emits IR for the visit of frame, returns the next child like a visit */
+fuco_node_t *fuco_node_generate_ir_step(fuco_walk_frame_t *frame, 
+                                        fuco_ir_walk_t *state);
 
-void fuco_node_generate_ir_propagate(fuco_node_t *node, fuco_ir_t *ir, 
-                                     size_t obj);
+/* Number of children descended into by local resolution and IR generation, 
+   which visit them in the same steps */
+size_t fuco_node_walk_size(fuco_node_t *node);
 
-void fuco_node_generate_ir_if_else(fuco_node_t *node, fuco_ir_t *ir, 
-                                   size_t obj);
+/* Coerces an operand whose code was just generated, emitting the 
+   conversion call if one is needed */
+int fuco_node_analyze_coerce(fuco_analysis_t *analysis, fuco_node_t **pnode, 
+                             fuco_node_t *type);
 
-void fuco_node_generate_ir_while(fuco_node_t *node, fuco_ir_t *ir, 
-                                 size_t obj);
+/* Fused local resolution and IR generation: each node is resolved when its 
+   children are done, right before its code is emitted */
+fuco_node_t *fuco_node_analyze_visit(fuco_walker_t *walker, 
+                                     fuco_walk_frame_t *frame);
 
-void fuco_node_generate_ir(fuco_node_t *node, fuco_ir_t *ir, 
-                           size_t obj);
+/* Resolves and generates the function node into object obj */
+int fuco_node_analyze(fuco_node_t *node, fuco_symboltable_t *table, 
+                      fuco_ir_t *ir, size_t obj);
 
 /* Returns size of parameters of node */
 size_t fuco_node_setup_offsets(fuco_node_t *node, uint64_t *defs);
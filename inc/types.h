@@ -0,0 +1,91 @@
+#ifndef FUCO_TYPES_H
+#define FUCO_TYPES_H
+
+#include "map.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Canonical type identity: two types are equal iff their ids are equal */
+typedef uint32_t fuco_typeid_t;
+
+#define FUCO_TYPEID_INVALID (fuco_typeid_t)0
+
+#define FUCO_TYPETABLE_INIT_SIZE 64
+
+typedef enum {
+    FUCO_TYPEKIND_NULL,
+    FUCO_TYPEKIND_NAMED,
+    FUCO_TYPEKIND_ARRAY,
+    FUCO_TYPEKIND_FUNCTION,
+    FUCO_TYPEKIND_GENERIC
+} fuco_typekind_t;
+
+#define FUCO_TYPEKIND_COUNT (FUCO_TYPEKIND_GENERIC + 1)
+
+/* Arguments by kind:
+   NAMED: none, symbol is the type symbol
+   ARRAY: element type
+   FUNCTION: return type followed by the parameter types
+   GENERIC: type arguments, symbol is the generic type symbol */
+typedef struct {
+    fuco_typekind_t kind;
+    uint32_t symbol;
+    /* Dense index among the types of the same kind */
+    uint32_t index;
+    /* Offset into the argument pool of the type table */
+    size_t args;
+    size_t n_args;
+} fuco_type_t;
+
+typedef struct {
+    /* Indexed by type id, entry 0 is the invalid type */
+    fuco_type_t *types;
+    size_t size;
+    size_t cap;
+    /* Number of types of each kind */
+    size_t counts[FUCO_TYPEKIND_COUNT];
+    fuco_typeid_t *pool;
+    size_t pool_size;
+    size_t pool_cap;
+    /* Open addressing hash set of type ids, 0 marks an empty bucket */
+    fuco_typeid_t *buckets;
+    size_t cap_buckets;
+} fuco_typetable_t;
+
+void fuco_typetable_init(fuco_typetable_t *types);
+
+void fuco_typetable_destruct(fuco_typetable_t *types);
+
+void fuco_typetable_write(fuco_typetable_t *types, FILE *file);
+
+fuco_hashvalue_t fuco_type_hash(fuco_typekind_t kind, uint32_t symbol, 
+                                fuco_typeid_t *args, size_t n_args);
+
+bool fuco_type_equal(fuco_typetable_t *types, fuco_typeid_t id, 
+                     fuco_typekind_t kind, uint32_t symbol, 
+                     fuco_typeid_t *args, size_t n_args);
+
+void fuco_typetable_rehash(fuco_typetable_t *types);
+
+/* Returns the id of the type, inserting it if it was not seen before */
+fuco_typeid_t fuco_typetable_intern(fuco_typetable_t *types, 
+                                    fuco_typekind_t kind, uint32_t symbol, 
+                                    fuco_typeid_t *args, size_t n_args);
+
+fuco_typeid_t fuco_typetable_named(fuco_typetable_t *types, uint32_t symbol);
+
+fuco_typeid_t fuco_typetable_array(fuco_typetable_t *types, 
+                                   fuco_typeid_t element);
+
+fuco_typeid_t fuco_typetable_function(fuco_typetable_t *types, 
+                                      fuco_typeid_t ret, 
+                                      fuco_typeid_t *params, size_t n_params);
+
+fuco_type_t *fuco_typetable_get(fuco_typetable_t *types, fuco_typeid_t id);
+
+fuco_typeid_t *fuco_typetable_get_args(fuco_typetable_t *types, 
+                                       fuco_typeid_t id);
+
+#endif
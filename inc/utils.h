@@ -27,8 +27,10 @@ void fuco_syntax_error(fuco_textsource_t *source, char const *format, ...);
 
 char fuco_base_char(int i);
 
-/* Static rotation: max. 16 uses at once */
-char *fuco_repr_char(char c);
+#define FUCO_REPR_CHAR_SIZE 5
+
+/* Writes the printable representation of c to buf of FUCO_REPR_CHAR_SIZE */
+char *fuco_repr_char(char c, char *buf);
 
 int fuco_ceil_log(unsigned int i, unsigned int base);
 
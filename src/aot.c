@@ -0,0 +1,546 @@
+#include "aot.h"
+#include "tree.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <sys/wait.h>
+
+/* C operators of FUCO_OPCODE_IADD through FUCO_OPCODE_IGE, applied to the
+   top of the stack and the value below it */
+char const *fuco_aot_operators[] = {
+    "+", "-", "*", "/", "%", "==", "!=", "<", "<=", ">", ">="
+};
+
+char const *fuco_aot_cflags[] = {
+    "-O2", "-shared", "-fPIC", "-DFUCO_AOT_SHARED", NULL
+};
+
+int64_t fuco_aot_arity(fuco_ir_t *ir, uint64_t address) {
+    fuco_ir_object_t *object = fuco_ir_object_at(ir, address);
+
+    if (object == NULL || object->address != address) {
+        return -1;
+    }
+
+    if (object->def == NULL) {
+        return 0;
+    }
+
+    return object->def->children[FUCO_LAYOUT_FUNCTION_PARAMS]->count;
+}
+
+int fuco_aot_visit(fuco_aot_function_t *function, size_t i, int64_t depth,
+                   size_t *work, size_t *n_work) {
+    if (i >= function->object->n_instrs) {
+        return 1;
+    }
+
+    if (function->depths[i] == -1) {
+        function->depths[i] = depth;
+        work[(*n_work)++] = i;
+    }
+
+    return function->depths[i] != depth;
+}
+
+/* Returns 1 if the instruction at i can not be translated at depth */
+int fuco_aot_step(fuco_aot_function_t *function, fuco_ir_t *ir,
+                  fuco_bytecode_t *bytecode, size_t i, size_t *work,
+                  size_t *n_work) {
+    fuco_ir_object_t *object = function->object;
+    fuco_instr_t instr = bytecode->instrs[object->address + i];
+    uint64_t imm48 = FUCO_GET_IMM48(instr);
+    int64_t depth = function->depths[i];
+    int64_t offset = FUCO_SEX_IMM48(imm48);
+    int64_t arity = fuco_aot_arity(ir, object->address);
+    int64_t pops = 0, pushes = 0;
+    bool next = true, branches = false;
+
+    switch (FUCO_GET_OPCODE(instr)) {
+        case FUCO_OPCODE_NOP:
+            break;
+
+        case FUCO_OPCODE_CALL:
+            if ((pops = fuco_aot_arity(ir, imm48)) == -1) {
+                return 1;
+            }
+            pushes = 1;
+            break;
+
+        case FUCO_OPCODE_QRET:
+        case FUCO_OPCODE_EXIT:
+            pops = 1;
+            next = false;
+            break;
+
+        case FUCO_OPCODE_QRLOAD:
+            /* Parameters are below the return address and saved bp */
+            if (offset > -24 || (-24 - offset) % 8 != 0
+                || (-24 - offset) / 8 >= arity) {
+                return 1;
+            }
+            pushes = 1;
+            break;
+
+        case FUCO_OPCODE_QPUSH:
+            pushes = 1;
+            break;
+
+        case FUCO_OPCODE_JUMP:
+            branches = true;
+            next = false;
+            break;
+
+        case FUCO_OPCODE_BRTRUE:
+        case FUCO_OPCODE_BRFALSE:
+            pops = 1;
+            branches = true;
+            break;
+
+        case FUCO_OPCODE_IADD:
+        case FUCO_OPCODE_ISUB:
+        case FUCO_OPCODE_IMUL:
+        case FUCO_OPCODE_IDIV:
+        case FUCO_OPCODE_IMOD:
+        case FUCO_OPCODE_IEQ:
+        case FUCO_OPCODE_INE:
+        case FUCO_OPCODE_ILT:
+        case FUCO_OPCODE_ILE:
+        case FUCO_OPCODE_IGT:
+        case FUCO_OPCODE_IGE:
+            pops = 2;
+            pushes = 1;
+            break;
+
+        case FUCO_OPCODE_ITOF:
+        case FUCO_OPCODE_FTOI:
+            pops = 1;
+            pushes = 1;
+            break;
+
+        /* Absolute loads are not generated */
+        case FUCO_OPCODE_QLOAD:
+        case FUCO_OPCODES_N:
+            return 1;
+    }
+
+    if (depth < pops) {
+        return 1;
+    }
+
+    depth += pushes - pops;
+    if ((size_t)depth > function->max_depth) {
+        function->max_depth = depth;
+    }
+
+    if (branches) {
+        if (imm48 < object->address) {
+            return 1;
+        }
+
+        size_t target = imm48 - object->address;
+
+        if (fuco_aot_visit(function, target, depth, work, n_work)) {
+            return 1;
+        }
+        function->targets[target] = true;
+    }
+
+    if (next && fuco_aot_visit(function, i + 1, depth, work, n_work)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+int fuco_aot_analyze(fuco_aot_function_t *function, fuco_ir_t *ir,
+                     fuco_bytecode_t *bytecode) {
+    size_t n = function->object->n_instrs;
+    size_t *work = malloc(n * sizeof(size_t));
+    size_t n_work = 0;
+    int error = 0;
+
+    function->depths = malloc(n * sizeof(int64_t));
+    function->targets = calloc(n, sizeof(bool));
+    function->max_depth = 0;
+    function->used = false;
+
+    for (size_t i = 0; i < n; i++) {
+        function->depths[i] = -1;
+    }
+
+    if (n > 0) {
+        fuco_aot_visit(function, 0, 0, work, &n_work);
+    }
+
+    /* Each instruction is queued once, when its depth is first known */
+    while (n_work > 0 && !error) {
+        size_t i = work[--n_work];
+
+        if (fuco_aot_step(function, ir, bytecode, i, work, &n_work)) {
+            fprintf(stderr, "fuco: cannot translate instruction %zu of ",
+                    i);
+            fuco_ir_object_write_name(function->object, stderr);
+            fprintf(stderr, " to C\n");
+
+            error = 1;
+        }
+    }
+
+    free(work);
+
+    return error;
+}
+
+void fuco_aot_mark_used(fuco_aot_function_t *functions, fuco_ir_t *ir,
+                        fuco_bytecode_t *bytecode) {
+    size_t *work = malloc(ir->size * sizeof(size_t));
+    size_t n_work = 0;
+
+    functions[0].used = true;
+    work[n_work++] = 0;
+
+    while (n_work > 0) {
+        fuco_aot_function_t *function = &functions[work[--n_work]];
+        fuco_ir_object_t *object = function->object;
+
+        for (size_t i = 0; i < object->n_instrs; i++) {
+            fuco_instr_t instr = bytecode->instrs[object->address + i];
+
+            if (function->depths[i] == -1
+                || FUCO_GET_OPCODE(instr) != FUCO_OPCODE_CALL) {
+                continue;
+            }
+
+            size_t callee = fuco_ir_object_at(ir, FUCO_GET_IMM48(instr))
+                            - ir->objects;
+
+            if (!functions[callee].used) {
+                functions[callee].used = true;
+                work[n_work++] = callee;
+            }
+        }
+    }
+
+    free(work);
+}
+
+void fuco_aot_prototype_write(fuco_ir_t *ir, uint64_t address, FILE *file) {
+    int64_t arity = fuco_aot_arity(ir, address);
+
+    fprintf(file, "static uint64_t fuco_f%lu(", address);
+
+    if (arity == 0) {
+        fprintf(file, "void");
+    }
+
+    for (int64_t i = 0; i < arity; i++) {
+        fprintf(file, "%suint64_t p%ld", i == 0 ? "" : ", ", i);
+    }
+
+    fprintf(file, ")");
+}
+
+void fuco_aot_function_write(fuco_aot_function_t *function, fuco_ir_t *ir,
+                             fuco_bytecode_t *bytecode, FILE *file) {
+    fuco_ir_object_t *object = function->object;
+
+    fprintf(file, "/* ");
+    fuco_ir_object_write_name(object, file);
+    fprintf(file, " */\n");
+
+    fuco_aot_prototype_write(ir, object->address, file);
+    fprintf(file, " {\n");
+
+    if (function->max_depth > 0) {
+        fprintf(file, "    uint64_t s0");
+        for (size_t i = 1; i < function->max_depth; i++) {
+            fprintf(file, ", s%zu", i);
+        }
+        fprintf(file, ";\n\n");
+    }
+
+    for (size_t i = 0; i < object->n_instrs; i++) {
+        uint64_t address = object->address + i;
+        fuco_instr_t instr = bytecode->instrs[address];
+        fuco_opcode_t opcode = FUCO_GET_OPCODE(instr);
+        uint64_t imm48 = FUCO_GET_IMM48(instr);
+        int64_t offset = FUCO_SEX_IMM48(imm48);
+        int64_t depth = function->depths[i];
+        int64_t arity;
+
+        if (depth == -1) {
+            continue;
+        }
+
+        if (function->targets[i]) {
+            fprintf(file, "L%lu:\n", address);
+        }
+
+        switch (opcode) {
+            case FUCO_OPCODE_NOP:
+                fprintf(file, "    ;\n");
+                break;
+
+            case FUCO_OPCODE_CALL:
+                arity = fuco_aot_arity(ir, imm48);
+
+                /* The first parameter was pushed last */
+                fprintf(file, "    s%ld = fuco_f%lu(", depth - arity, imm48);
+                for (int64_t j = 0; j < arity; j++) {
+                    fprintf(file, "%ss%ld", j == 0 ? "" : ", ",
+                            depth - 1 - j);
+                }
+                fprintf(file, ");\n");
+                break;
+
+            case FUCO_OPCODE_QRET:
+            case FUCO_OPCODE_EXIT:
+                fprintf(file, "    return s%ld;\n", depth - 1);
+                break;
+
+            case FUCO_OPCODE_QRLOAD:
+                fprintf(file, "    s%ld = p%ld;\n", depth, (-24 - offset) / 8);
+                break;
+
+            case FUCO_OPCODE_QPUSH:
+                fprintf(file, "    s%ld = %luu;\n", depth, imm48);
+                break;
+
+            case FUCO_OPCODE_JUMP:
+                fprintf(file, "    goto L%lu;\n", imm48);
+                break;
+
+            case FUCO_OPCODE_BRTRUE:
+            case FUCO_OPCODE_BRFALSE:
+                fprintf(file, "    if (s%ld %s 0) goto L%lu;\n", depth - 1,
+                        opcode == FUCO_OPCODE_BRTRUE ? "!=" : "==", imm48);
+                break;
+
+            case FUCO_OPCODE_IADD:
+            case FUCO_OPCODE_ISUB:
+            case FUCO_OPCODE_IMUL:
+            case FUCO_OPCODE_IDIV:
+            case FUCO_OPCODE_IMOD:
+            case FUCO_OPCODE_IEQ:
+            case FUCO_OPCODE_INE:
+            case FUCO_OPCODE_ILT:
+            case FUCO_OPCODE_ILE:
+            case FUCO_OPCODE_IGT:
+            case FUCO_OPCODE_IGE:
+                fprintf(file, "    s%ld = s%ld %s s%ld;\n", depth - 2,
+                        depth - 1,
+                        fuco_aot_operators[opcode - FUCO_OPCODE_IADD],
+                        depth - 2);
+                break;
+
+            case FUCO_OPCODE_ITOF:
+                fprintf(file, "    s%ld = fuco_itof(s%ld);\n", depth - 1,
+                        depth - 1);
+                break;
+
+            case FUCO_OPCODE_FTOI:
+                fprintf(file, "    s%ld = fuco_ftoi(s%ld);\n", depth - 1,
+                        depth - 1);
+                break;
+
+            case FUCO_OPCODE_QLOAD:
+            case FUCO_OPCODES_N:
+                FUCO_UNREACHED();
+        }
+    }
+
+    fprintf(file, "}\n\n");
+}
+
+int fuco_aot_write(fuco_ir_t *ir, fuco_bytecode_t *bytecode, FILE *file) {
+    fuco_aot_function_t *functions
+            = malloc(ir->size * sizeof(fuco_aot_function_t));
+    int error = 0;
+
+    for (size_t i = 0; i < ir->size; i++) {
+        functions[i].object = &ir->objects[i];
+
+        if (fuco_aot_analyze(&functions[i], ir, bytecode)) {
+            error = 1;
+        }
+    }
+
+    if (!error) {
+        fuco_aot_mark_used(functions, ir, bytecode);
+
+        fprintf(file,
+                "/* Generated by fuco --emit-c */\n"
+                "#include <stdint.h>\n"
+                "#include <string.h>\n\n"
+                "/* Floats are held as the bits of a double */\n"
+                "static inline uint64_t fuco_itof(uint64_t x) {\n"
+                "    double f = (double)x;\n"
+                "    memcpy(&x, &f, sizeof(x));\n"
+                "    return x;\n"
+                "}\n\n"
+                "static inline uint64_t fuco_ftoi(uint64_t x) {\n"
+                "    double f;\n"
+                "    memcpy(&f, &x, sizeof(f));\n"
+                "    return (uint64_t)f;\n"
+                "}\n\n");
+
+        for (size_t i = 0; i < ir->size; i++) {
+            if (functions[i].used) {
+                fuco_aot_prototype_write(ir, ir->objects[i].address, file);
+                fprintf(file, ";\n");
+            }
+        }
+        fprintf(file, "\n");
+
+        for (size_t i = 0; i < ir->size; i++) {
+            if (functions[i].used) {
+                fuco_aot_function_write(&functions[i], ir, bytecode, file);
+            }
+        }
+
+        fprintf(file,
+                "int32_t " FUCO_AOT_ENTRY "(void) {\n"
+                "    return (int32_t)fuco_f%lu();\n"
+                "}\n\n"
+                "#ifndef FUCO_AOT_SHARED\n"
+                "int main(void) {\n"
+                "    return " FUCO_AOT_ENTRY "();\n"
+                "}\n"
+                "#endif\n", ir->objects[0].address);
+    }
+
+    for (size_t i = 0; i < ir->size; i++) {
+        free(functions[i].depths);
+        free(functions[i].targets);
+    }
+    free(functions);
+
+    return error;
+}
+
+int fuco_aot_build(char const **flags, char const *source,
+                   char const *output) {
+    char const *env = getenv("CC");
+    char *cc, *word, *save;
+    size_t n_words = 0, n_flags = 0, argc = 0;
+
+    if (env == NULL || *env == '\0') {
+        env = FUCO_AOT_CC;
+    }
+
+    cc = strdup(env);
+    n_words = strlen(cc); /* Bounds the number of words */
+
+    while (flags != NULL && flags[n_flags] != NULL) {
+        n_flags++;
+    }
+
+    /* Driver words, flags, -o output source and the terminator */
+    char const **argv = malloc((n_words + n_flags + 4) * sizeof(char *));
+
+    for (word = strtok_r(cc, " \t", &save); word != NULL;
+         word = strtok_r(NULL, " \t", &save)) {
+        argv[argc++] = word;
+    }
+
+    if (argc == 0) {
+        fprintf(stderr, "fuco: CC is empty\n");
+        free(argv);
+        free(cc);
+        return 1;
+    }
+
+    for (size_t i = 0; i < n_flags; i++) {
+        argv[argc++] = flags[i];
+    }
+
+    argv[argc++] = "-o";
+    argv[argc++] = output;
+    argv[argc++] = source;
+    argv[argc] = NULL;
+
+    int status = -1;
+    pid_t pid = fork();
+
+    if (pid == -1) {
+        perror("fork");
+    } else if (pid == 0) {
+        execvp(argv[0], (char **)argv);
+        perror(argv[0]);
+        _exit(127);
+    } else if (waitpid(pid, &status, 0) == -1) {
+        perror("waitpid");
+        status = -1;
+    }
+
+    int error = status == -1 || !WIFEXITED(status)
+                || WEXITSTATUS(status) != 0;
+
+    if (error && pid > 0) {
+        fprintf(stderr, "fuco: '%s' failed\n", argv[0]);
+    }
+
+    free(argv);
+    free(cc);
+
+    return error;
+}
+
+int fuco_aot_run(fuco_ir_t *ir, fuco_bytecode_t *bytecode, int32_t *status) {
+    char dir[] = "/tmp/fuco-XXXXXX";
+    char source[sizeof(dir) + 16], library[sizeof(dir) + 16];
+    int32_t (*entry)(void) = NULL;
+    void *handle = NULL;
+    FILE *file;
+    int error;
+
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    snprintf(source, sizeof(source), "%s/program.c", dir);
+    snprintf(library, sizeof(library), "%s/program.so", dir);
+
+    if ((file = fopen(source, "w")) == NULL) {
+        perror(source);
+        rmdir(dir);
+        return 1;
+    }
+
+    error = fuco_aot_write(ir, bytecode, file);
+    error = fclose(file) != 0 || error;
+
+    if (!error) {
+        error = fuco_aot_build(fuco_aot_cflags, source, library);
+    }
+
+    if (!error && (handle = dlopen(library, RTLD_NOW)) == NULL) {
+        fprintf(stderr, "fuco: %s\n", dlerror());
+        error = 1;
+    }
+
+    /* Object to function pointer conversion as POSIX specifies for dlsym */
+    if (!error && (*(void **)&entry = dlsym(handle, FUCO_AOT_ENTRY)) == NULL) {
+        fprintf(stderr, "fuco: %s\n", dlerror());
+        error = 1;
+    }
+
+    /* Removed before running, the mapping outlives the file */
+    unlink(library);
+    unlink(source);
+    rmdir(dir);
+
+    if (!error) {
+        *status = entry();
+    }
+
+    if (handle != NULL) {
+        dlclose(handle);
+    }
+
+    return error;
+}
@@ -0,0 +1,531 @@
+#include "asm.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+char const *fuco_asm_registers[FUCO_ASM_N_REGISTERS] = {
+    "%rbx", "%r12", "%r13", "%r14", "%r15"
+};
+
+char const *fuco_asm_arg_registers[FUCO_ASM_N_ARG_REGISTERS] = {
+    "%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"
+};
+
+/* Condition codes of FUCO_OPCODE_IEQ through FUCO_OPCODE_IGE, unsigned as
+   in the interpreter */
+char const *fuco_asm_conditions[] = {
+    "e", "ne", "b", "be", "a", "ae"
+};
+
+int fuco_asm_compare_intervals(void const *left, void const *right) {
+    fuco_asm_interval_t const *x = left, *y = right;
+
+    return (x->start > y->start) - (x->start < y->start);
+}
+
+/* Slots referenced by instruction i, conservatively including the slots
+   live into the next instruction */
+size_t fuco_asm_live_depth(fuco_aot_function_t *function, size_t i) {
+    int64_t depth = function->depths[i];
+
+    if (i + 1 < function->object->n_instrs
+        && function->depths[i + 1] > depth) {
+        depth = function->depths[i + 1];
+    }
+
+    return depth < 0 ? 0 : depth;
+}
+
+void fuco_asm_allocate(fuco_asm_function_t *function) {
+    fuco_aot_function_t *analysis = function->function;
+    size_t n_slots = analysis->max_depth;
+    fuco_asm_interval_t *intervals
+            = malloc(n_slots * sizeof(fuco_asm_interval_t));
+    fuco_asm_interval_t *active[FUCO_ASM_N_REGISTERS];
+    size_t n_active = 0, n_intervals = 0;
+
+    function->registers = malloc(n_slots * sizeof(int));
+    function->homes = malloc(n_slots * sizeof(size_t));
+    function->n_used = 0;
+    function->n_homes = FUCO_MIN(function->arity, FUCO_ASM_N_ARG_REGISTERS);
+
+    for (size_t i = 0; i < FUCO_ASM_N_REGISTERS; i++) {
+        function->used[i] = false;
+    }
+
+    for (size_t slot = 0; slot < n_slots; slot++) {
+        fuco_asm_interval_t *interval = &intervals[n_intervals];
+
+        interval->slot = slot;
+        interval->start = SIZE_MAX;
+        interval->end = 0;
+
+        for (size_t i = 0; i < analysis->object->n_instrs; i++) {
+            if (fuco_asm_live_depth(analysis, i) > slot) {
+                interval->start = FUCO_MIN(interval->start, i);
+                interval->end = i;
+            }
+        }
+
+        function->registers[slot] = -1;
+        if (interval->start != SIZE_MAX) {
+            n_intervals++;
+        }
+    }
+
+    qsort(intervals, n_intervals, sizeof(fuco_asm_interval_t),
+          fuco_asm_compare_intervals);
+
+    /* active is kept sorted by end */
+    for (size_t i = 0; i < n_intervals; i++) {
+        fuco_asm_interval_t *interval = &intervals[i];
+        size_t expired = 0;
+
+        while (expired < n_active && active[expired]->end < interval->start) {
+            expired++;
+        }
+
+        memmove(active, active + expired,
+                (n_active - expired) * sizeof(fuco_asm_interval_t *));
+        n_active -= expired;
+
+        int reg = -1;
+
+        if (n_active == FUCO_ASM_N_REGISTERS) {
+            fuco_asm_interval_t *last = active[n_active - 1];
+
+            if (last->end > interval->end) {
+                reg = function->registers[last->slot];
+                function->registers[last->slot] = -1;
+                n_active--;
+            }
+        } else {
+            bool taken[FUCO_ASM_N_REGISTERS] = { false };
+
+            for (size_t j = 0; j < n_active; j++) {
+                taken[function->registers[active[j]->slot]] = true;
+            }
+
+            reg = 0;
+            while (taken[reg]) {
+                reg++;
+            }
+        }
+
+        if (reg == -1) {
+            continue;
+        }
+
+        function->registers[interval->slot] = reg;
+
+        size_t j = n_active;
+        while (j > 0 && active[j - 1]->end > interval->end) {
+            active[j] = active[j - 1];
+            j--;
+        }
+        active[j] = interval;
+        n_active++;
+    }
+
+    for (size_t slot = 0; slot < n_slots; slot++) {
+        int reg = function->registers[slot];
+
+        if (reg == -1) {
+            function->homes[slot] = function->n_homes++;
+        } else if (!function->used[reg]) {
+            function->used[reg] = true;
+            function->n_used++;
+        }
+    }
+
+    free(intervals);
+}
+
+void fuco_asm_function_destruct(fuco_asm_function_t *function) {
+    free(function->registers);
+    free(function->homes);
+}
+
+/* Homes are below the saved registers */
+char const *fuco_asm_home(fuco_asm_function_t *function, size_t home,
+                          char *buffer) {
+    snprintf(buffer, FUCO_ASM_OPERAND_SIZE, "%ld(%%rbp)",
+             -8 * (int64_t)(function->n_used + 1 + home));
+
+    return buffer;
+}
+
+char const *fuco_asm_slot(fuco_asm_function_t *function, int64_t slot,
+                          char *buffer) {
+    int reg = function->registers[slot];
+
+    if (reg != -1) {
+        snprintf(buffer, FUCO_ASM_OPERAND_SIZE, "%s", fuco_asm_registers[reg]);
+        return buffer;
+    }
+
+    return fuco_asm_home(function, function->homes[slot], buffer);
+}
+
+/* Parameters after the register ones are above the return address */
+char const *fuco_asm_param(fuco_asm_function_t *function, int64_t i,
+                           char *buffer) {
+    if (i < FUCO_ASM_N_ARG_REGISTERS) {
+        return fuco_asm_home(function, i, buffer);
+    }
+
+    snprintf(buffer, FUCO_ASM_OPERAND_SIZE, "%ld(%%rbp)",
+             16 + 8 * (i - FUCO_ASM_N_ARG_REGISTERS));
+
+    return buffer;
+}
+
+/* Memory to memory moves go through %rax */
+void fuco_asm_move(char const *src, char const *dst, FILE *file) {
+    if (src[0] != '%' && dst[0] != '%') {
+        fprintf(file, "    movq %s, %%rax\n", src);
+        src = "%rax";
+    }
+
+    fprintf(file, "    movq %s, %s\n", src, dst);
+}
+
+void fuco_asm_call_write(fuco_asm_function_t *function, uint64_t target,
+                         int64_t arity, int64_t depth, FILE *file) {
+    char buffer[FUCO_ASM_OPERAND_SIZE];
+    int64_t n_stack = arity - FUCO_ASM_N_ARG_REGISTERS;
+    int64_t pad = 0;
+
+    if (n_stack < 0) {
+        n_stack = 0;
+    }
+
+    /* The frame is aligned, keep it so at the call */
+    if (n_stack % 2) {
+        pad = 8;
+        fprintf(file, "    subq $8, %%rsp\n");
+    }
+
+    /* The first parameter is on top of the operand stack */
+    for (int64_t i = arity - 1; i >= FUCO_ASM_N_ARG_REGISTERS; i--) {
+        fprintf(file, "    pushq %s\n",
+                fuco_asm_slot(function, depth - 1 - i, buffer));
+    }
+
+    for (int64_t i = 0; i < arity && i < FUCO_ASM_N_ARG_REGISTERS; i++) {
+        fprintf(file, "    movq %s, %s\n",
+                fuco_asm_slot(function, depth - 1 - i, buffer),
+                fuco_asm_arg_registers[i]);
+    }
+
+    fprintf(file, "    call fuco_f%lu\n", target);
+
+    if (n_stack > 0 || pad > 0) {
+        fprintf(file, "    addq $%ld, %%rsp\n", 8 * n_stack + pad);
+    }
+
+    fuco_asm_move("%rax", fuco_asm_slot(function, depth - arity, buffer),
+                  file);
+}
+
+void fuco_asm_instr_write(fuco_asm_function_t *function, fuco_ir_t *ir,
+                          fuco_instr_t instr, int64_t depth, FILE *file) {
+    char top[FUCO_ASM_OPERAND_SIZE], below[FUCO_ASM_OPERAND_SIZE];
+    char result[FUCO_ASM_OPERAND_SIZE];
+    fuco_opcode_t opcode = FUCO_GET_OPCODE(instr);
+    uint64_t imm48 = FUCO_GET_IMM48(instr);
+    int64_t offset = FUCO_SEX_IMM48(imm48);
+    uint64_t address = function->function->object->address;
+
+    switch (opcode) {
+        case FUCO_OPCODE_NOP:
+            break;
+
+        case FUCO_OPCODE_CALL:
+            fuco_asm_call_write(function, imm48, fuco_aot_arity(ir, imm48),
+                                depth, file);
+            break;
+
+        case FUCO_OPCODE_QRET:
+        case FUCO_OPCODE_EXIT:
+            fprintf(file, "    movq %s, %%rax\n",
+                    fuco_asm_slot(function, depth - 1, top));
+            fprintf(file, "    jmp .Lret%lu\n", address);
+            break;
+
+        case FUCO_OPCODE_QRLOAD:
+            fuco_asm_move(fuco_asm_param(function, (-24 - offset) / 8, top),
+                          fuco_asm_slot(function, depth, result), file);
+            break;
+
+        case FUCO_OPCODE_QPUSH:
+            fuco_asm_slot(function, depth, result);
+
+            if (imm48 > INT32_MAX) {
+                fprintf(file, "    movabsq $%lu, %%rax\n", imm48);
+                fprintf(file, "    movq %%rax, %s\n", result);
+            } else {
+                fprintf(file, "    movq $%lu, %s\n", imm48, result);
+            }
+            break;
+
+        case FUCO_OPCODE_JUMP:
+            fprintf(file, "    jmp .L%lu\n", imm48);
+            break;
+
+        case FUCO_OPCODE_BRTRUE:
+        case FUCO_OPCODE_BRFALSE:
+            fprintf(file, "    cmpq $0, %s\n",
+                    fuco_asm_slot(function, depth - 1, top));
+            fprintf(file, "    j%s .L%lu\n",
+                    opcode == FUCO_OPCODE_BRTRUE ? "ne" : "e", imm48);
+            break;
+
+        case FUCO_OPCODE_IADD:
+        case FUCO_OPCODE_ISUB:
+        case FUCO_OPCODE_IMUL:
+            fuco_asm_slot(function, depth - 1, top);
+            fuco_asm_slot(function, depth - 2, below);
+
+            fprintf(file, "    movq %s, %%rax\n", top);
+            fprintf(file, "    %s %s, %%rax\n",
+                    opcode == FUCO_OPCODE_IADD ? "addq"
+                    : opcode == FUCO_OPCODE_ISUB ? "subq" : "imulq", below);
+            fprintf(file, "    movq %%rax, %s\n", below);
+            break;
+
+        case FUCO_OPCODE_IDIV:
+        case FUCO_OPCODE_IMOD:
+            fuco_asm_slot(function, depth - 1, top);
+            fuco_asm_slot(function, depth - 2, below);
+
+            fprintf(file, "    movq %s, %%rax\n", top);
+            fprintf(file, "    xorl %%edx, %%edx\n");
+            fprintf(file, "    divq %s\n", below);
+            fprintf(file, "    movq %s, %s\n",
+                    opcode == FUCO_OPCODE_IDIV ? "%rax" : "%rdx", below);
+            break;
+
+        case FUCO_OPCODE_IEQ:
+        case FUCO_OPCODE_INE:
+        case FUCO_OPCODE_ILT:
+        case FUCO_OPCODE_ILE:
+        case FUCO_OPCODE_IGT:
+        case FUCO_OPCODE_IGE:
+            fuco_asm_slot(function, depth - 1, top);
+            fuco_asm_slot(function, depth - 2, below);
+
+            fprintf(file, "    movq %s, %%rax\n", top);
+            fprintf(file, "    cmpq %s, %%rax\n", below);
+            fprintf(file, "    set%s %%al\n",
+                    fuco_asm_conditions[opcode - FUCO_OPCODE_IEQ]);
+            fprintf(file, "    movzbq %%al, %%rax\n");
+            fprintf(file, "    movq %%rax, %s\n", below);
+            break;
+
+        case FUCO_OPCODE_ITOF:
+            /* Unsigned conversion, halving values with the top bit set */
+            fuco_asm_slot(function, depth - 1, top);
+
+            fprintf(file,
+                    "    movq %s, %%rax\n"
+                    "    testq %%rax, %%rax\n"
+                    "    js 1f\n"
+                    "    cvtsi2sdq %%rax, %%xmm0\n"
+                    "    jmp 2f\n"
+                    "1:\n"
+                    "    movq %%rax, %%rcx\n"
+                    "    shrq %%rcx\n"
+                    "    andl $1, %%eax\n"
+                    "    orq %%rax, %%rcx\n"
+                    "    cvtsi2sdq %%rcx, %%xmm0\n"
+                    "    addsd %%xmm0, %%xmm0\n"
+                    "2:\n"
+                    "    movq %%xmm0, %%rax\n"
+                    "    movq %%rax, %s\n", top, top);
+            break;
+
+        case FUCO_OPCODE_FTOI:
+            /* Values from 2^63 on are offset into the signed range */
+            fuco_asm_slot(function, depth - 1, top);
+
+            fprintf(file,
+                    "    movq %s, %%rax\n"
+                    "    movq %%rax, %%xmm0\n"
+                    "    movabsq $0x43e0000000000000, %%rcx\n"
+                    "    movq %%rcx, %%xmm1\n"
+                    "    comisd %%xmm1, %%xmm0\n"
+                    "    jae 1f\n"
+                    "    cvttsd2siq %%xmm0, %%rax\n"
+                    "    jmp 2f\n"
+                    "1:\n"
+                    "    subsd %%xmm1, %%xmm0\n"
+                    "    cvttsd2siq %%xmm0, %%rax\n"
+                    "    btcq $63, %%rax\n"
+                    "2:\n"
+                    "    movq %%rax, %s\n", top, top);
+            break;
+
+        case FUCO_OPCODE_QLOAD:
+        case FUCO_OPCODES_N:
+            FUCO_UNREACHED();
+    }
+}
+
+void fuco_asm_function_write(fuco_asm_function_t *function, fuco_ir_t *ir,
+                             fuco_bytecode_t *bytecode, FILE *file) {
+    fuco_aot_function_t *analysis = function->function;
+    fuco_ir_object_t *object = analysis->object;
+    char buffer[FUCO_ASM_OPERAND_SIZE];
+    size_t frame = 8 * function->n_homes;
+
+    /* The saved registers and homes keep %rsp aligned to 16 */
+    if ((function->n_used * 8 + frame) % 16 != 0) {
+        frame += 8;
+    }
+
+    fprintf(file, "# ");
+    fuco_ir_object_write_name(object, file);
+    fprintf(file, "\n    .type fuco_f%lu, @function\n", object->address);
+    fprintf(file, "fuco_f%lu:\n", object->address);
+    fprintf(file, "    pushq %%rbp\n");
+    fprintf(file, "    movq %%rsp, %%rbp\n");
+
+    for (size_t i = 0; i < FUCO_ASM_N_REGISTERS; i++) {
+        if (function->used[i]) {
+            fprintf(file, "    pushq %s\n", fuco_asm_registers[i]);
+        }
+    }
+
+    if (frame > 0) {
+        fprintf(file, "    subq $%zu, %%rsp\n", frame);
+    }
+
+    for (int64_t i = 0; i < function->arity && i < FUCO_ASM_N_ARG_REGISTERS;
+         i++) {
+        fprintf(file, "    movq %s, %s\n", fuco_asm_arg_registers[i],
+                fuco_asm_home(function, i, buffer));
+    }
+
+    for (size_t i = 0; i < object->n_instrs; i++) {
+        uint64_t address = object->address + i;
+
+        if (analysis->depths[i] == -1) {
+            continue;
+        }
+
+        if (analysis->targets[i]) {
+            fprintf(file, ".L%lu:\n", address);
+        }
+
+        fuco_asm_instr_write(function, ir, bytecode->instrs[address],
+                             analysis->depths[i], file);
+    }
+
+    fprintf(file, ".Lret%lu:\n", object->address);
+    fprintf(file, "    leaq %ld(%%rbp), %%rsp\n",
+            -8 * (int64_t)function->n_used);
+
+    for (size_t i = FUCO_ASM_N_REGISTERS; i > 0; i--) {
+        if (function->used[i - 1]) {
+            fprintf(file, "    popq %s\n", fuco_asm_registers[i - 1]);
+        }
+    }
+
+    fprintf(file, "    popq %%rbp\n");
+    fprintf(file, "    ret\n");
+    fprintf(file, "    .size fuco_f%lu, .-fuco_f%lu\n\n", object->address,
+            object->address);
+}
+
+int fuco_asm_write(fuco_ir_t *ir, fuco_bytecode_t *bytecode, FILE *file) {
+    fuco_aot_function_t *functions
+            = malloc(ir->size * sizeof(fuco_aot_function_t));
+    int error = 0;
+
+    for (size_t i = 0; i < ir->size; i++) {
+        functions[i].object = &ir->objects[i];
+
+        if (fuco_aot_analyze(&functions[i], ir, bytecode)) {
+            error = 1;
+        }
+    }
+
+    if (!error) {
+        fuco_aot_mark_used(functions, ir, bytecode);
+
+        fprintf(file,
+                "# Generated by fuco --emit-asm\n"
+                "    .text\n\n");
+
+        for (size_t i = 0; i < ir->size; i++) {
+            fuco_asm_function_t function;
+
+            if (!functions[i].used) {
+                continue;
+            }
+
+            function.function = &functions[i];
+            function.arity = fuco_aot_arity(ir, ir->objects[i].address);
+
+            fuco_asm_allocate(&function);
+            fuco_asm_function_write(&function, ir, bytecode, file);
+            fuco_asm_function_destruct(&function);
+        }
+
+        /* The exit code is the low 32 bits, as returned by the interpreter */
+        fprintf(file,
+                "    .globl main\n"
+                "    .type main, @function\n"
+                "main:\n"
+                "    subq $8, %%rsp\n"
+                "    call fuco_f%lu\n"
+                "    addq $8, %%rsp\n"
+                "    ret\n"
+                "    .size main, .-main\n\n"
+                "    .section .note.GNU-stack,\"\",@progbits\n",
+                ir->objects[0].address);
+    }
+
+    for (size_t i = 0; i < ir->size; i++) {
+        free(functions[i].depths);
+        free(functions[i].targets);
+    }
+    free(functions);
+
+    return error;
+}
+
+int fuco_asm_build(fuco_ir_t *ir, fuco_bytecode_t *bytecode,
+                   char const *executable) {
+    char dir[] = "/tmp/fuco-XXXXXX";
+    char source[sizeof(dir) + 16];
+    FILE *file;
+    int error;
+
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    snprintf(source, sizeof(source), "%s/program.s", dir);
+
+    if ((file = fopen(source, "w")) == NULL) {
+        perror(source);
+        rmdir(dir);
+        return 1;
+    }
+
+    error = fuco_asm_write(ir, bytecode, file);
+    error = fclose(file) != 0 || error;
+
+    if (!error) {
+        error = fuco_aot_build(NULL, source, executable);
+    }
+
+    unlink(source);
+    rmdir(dir);
+
+    return error;
+}
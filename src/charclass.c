@@ -0,0 +1,181 @@
+#include "charclass.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+uint8_t const fuco_charclass_table[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x21, 0x01, 0x00, 0x00, 0x21, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x21, 0x30, 0x20, 0x20, 0x20, 0x30, 0x30, 0x20,
+    0x20, 0x20, 0x30, 0x30, 0x20, 0x30, 0x20, 0x30,
+    0x2c, 0x2c, 0x2c, 0x2c, 0x2c, 0x2c, 0x2c, 0x2c,
+    0x2c, 0x2c, 0x20, 0x20, 0x30, 0x30, 0x30, 0x20,
+    0x20, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26,
+    0x26, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26,
+    0x26, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26,
+    0x26, 0x26, 0x26, 0x20, 0x20, 0x20, 0x30, 0x26,
+    0x20, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26,
+    0x26, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26,
+    0x26, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26, 0x26,
+    0x26, 0x26, 0x26, 0x20, 0x30, 0x20, 0x30, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* Byte-wise lo <= x <= hi using signed compares: bias lo to INT8_MIN */
+#define FUCO_SSE2_RANGE(x, lo, hi) \
+        _mm_cmplt_epi8(_mm_add_epi8((x), _mm_set1_epi8((char)(0x80 - (lo)))), \
+                       _mm_set1_epi8((char)(0x80 + (hi) - (lo) + 1)))
+
+#define FUCO_AVX2_RANGE(x, lo, hi) \
+        _mm256_cmpgt_epi8( \
+            _mm256_set1_epi8((char)(0x80 + (hi) - (lo) + 1)), \
+            _mm256_add_epi8((x), _mm256_set1_epi8((char)(0x80 - (lo)))))
+
+#define FUCO_SSE2_IDENTIFIER(x) \
+        _mm_or_si128( \
+            _mm_or_si128(FUCO_SSE2_RANGE(_mm_or_si128((x), \
+                                                       _mm_set1_epi8(0x20)), \
+                                          'a', 'z'), \
+                         FUCO_SSE2_RANGE((x), '0', '9')), \
+            _mm_cmpeq_epi8((x), _mm_set1_epi8('_')))
+
+#define FUCO_AVX2_IDENTIFIER(x) \
+        _mm256_or_si256( \
+            _mm256_or_si256( \
+                FUCO_AVX2_RANGE(_mm256_or_si256((x), _mm256_set1_epi8(0x20)), \
+                                'a', 'z'), \
+                FUCO_AVX2_RANGE((x), '0', '9')), \
+            _mm256_cmpeq_epi8((x), _mm256_set1_epi8('_')))
+
+/* Comment bytes: printable, '\t' or '\r' */
+#define FUCO_SSE2_COMMENT(x) \
+        _mm_or_si128( \
+            FUCO_SSE2_RANGE((x), 0x20, 0x7E), \
+            _mm_or_si128(_mm_cmpeq_epi8((x), _mm_set1_epi8('\t')), \
+                         _mm_cmpeq_epi8((x), _mm_set1_epi8('\r'))))
+
+#define FUCO_AVX2_COMMENT(x) \
+        _mm256_or_si256( \
+            FUCO_AVX2_RANGE((x), 0x20, 0x7E), \
+            _mm256_or_si256(_mm256_cmpeq_epi8((x), _mm256_set1_epi8('\t')), \
+                            _mm256_cmpeq_epi8((x), _mm256_set1_epi8('\r'))))
+
+#define FUCO_SSE2_SPACE(x) \
+        _mm_or_si128( \
+            _mm_or_si128(_mm_cmpeq_epi8((x), _mm_set1_epi8(' ')), \
+                         _mm_cmpeq_epi8((x), _mm_set1_epi8('\n'))), \
+            _mm_or_si128(_mm_cmpeq_epi8((x), _mm_set1_epi8('\t')), \
+                         _mm_cmpeq_epi8((x), _mm_set1_epi8('\r'))))
+
+#define FUCO_AVX2_SPACE(x) \
+        _mm256_or_si256( \
+            _mm256_or_si256(_mm256_cmpeq_epi8((x), _mm256_set1_epi8(' ')), \
+                            _mm256_cmpeq_epi8((x), _mm256_set1_epi8('\n'))), \
+            _mm256_or_si256(_mm256_cmpeq_epi8((x), _mm256_set1_epi8('\t')), \
+                            _mm256_cmpeq_epi8((x), _mm256_set1_epi8('\r'))))
+
+/* Advances p over full blocks whose bytes all match the class; on a partial 
+   match, returns the first mismatching position */
+#define FUCO_SCAN_BLOCKS(p, end, CLASS) \
+        FUCO_SCAN_BLOCKS_AVX2(p, end, CLASS) \
+        FUCO_SCAN_BLOCKS_SSE2(p, end, CLASS)
+
+#if defined(__AVX2__)
+#define FUCO_SCAN_BLOCKS_AVX2(p, end, CLASS) \
+        while ((end) - (p) >= 32) { \
+            __m256i x = _mm256_loadu_si256((__m256i const *)(p)); \
+            uint32_t mask = _mm256_movemask_epi8(FUCO_AVX2_##CLASS(x)); \
+            if (mask != 0xFFFFFFFF) { \
+                return (p) + __builtin_ctz(~mask); \
+            } \
+            (p) += 32; \
+        }
+#else
+#define FUCO_SCAN_BLOCKS_AVX2(p, end, CLASS)
+#endif
+
+#if defined(__SSE2__)
+#define FUCO_SCAN_BLOCKS_SSE2(p, end, CLASS) \
+        while ((end) - (p) >= 16) { \
+            __m128i x = _mm_loadu_si128((__m128i const *)(p)); \
+            uint32_t mask = _mm_movemask_epi8(FUCO_SSE2_##CLASS(x)); \
+            if (mask != 0xFFFF) { \
+                return (p) + __builtin_ctz(~mask); \
+            } \
+            (p) += 16; \
+        }
+#else
+#define FUCO_SCAN_BLOCKS_SSE2(p, end, CLASS)
+#endif
+
+char *fuco_scan_identifier(char *p, char *end) {
+    FUCO_SCAN_BLOCKS(p, end, IDENTIFIER)
+
+    while (p < end && FUCO_CHARCLASS(*p, FUCO_CHAR_IDENTIFIER_CONTINUE)) {
+        p++;
+    }
+
+    return p;
+}
+
+char *fuco_scan_number(char *p, char *end) {
+#if defined(__SSE2__)
+    /* Numbers are short: a single block usually covers them */
+    while (end - p >= 16) {
+        __m128i x = _mm_loadu_si128((__m128i const *)p);
+        uint32_t mask = _mm_movemask_epi8(FUCO_SSE2_RANGE(x, '0', '9'));
+
+        if (mask != 0xFFFF) {
+            return p + __builtin_ctz(~mask);
+        }
+
+        p += 16;
+    }
+#endif
+
+    while (p < end && FUCO_CHARCLASS(*p, FUCO_CHAR_DIGIT)) {
+        p++;
+    }
+
+    return p;
+}
+
+char *fuco_scan_comment(char *p, char *end) {
+    FUCO_SCAN_BLOCKS(p, end, COMMENT)
+
+    while (p < end && FUCO_CHARCLASS(*p, FUCO_CHAR_COMMENT)) {
+        p++;
+    }
+
+    return p;
+}
+
+char *fuco_scan_space(char *p, char *end) {
+    FUCO_SCAN_BLOCKS(p, end, SPACE)
+
+    while (p < end && FUCO_CHARCLASS(*p, FUCO_CHAR_SPACE)) {
+        p++;
+    }
+
+    return p;
+}
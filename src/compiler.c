@@ -1,21 +1,78 @@
 #include "compiler.h"
 #include "lexer.h"
 #include "tokenlist.h"
+#include "threadpool.h"
 #include "utils.h"
+#include <stdlib.h>
+#include <string.h>
 
-void fuco_compiler_init(fuco_compiler_t *compiler, char *filename) {
-    fuco_lexer_init(&compiler->lexer);
-    fuco_parser_init(&compiler->parser);
+char const *fuco_emit_names[] = {
+    "tokens", "ast", "symbols", "ir", "bytecode"
+};
+
+fuco_emit_t fuco_emit_lookup(char const *name, size_t n) {
+    for (size_t i = 0; i < FUCO_ARRAY_SIZE(fuco_emit_names); i++) {
+        if (strlen(fuco_emit_names[i]) == n 
+            && strncmp(fuco_emit_names[i], name, n) == 0) {
+            return 1 << i;
+        }
+    }
+
+    return FUCO_EMIT_NONE;
+}
+
+void fuco_unit_init(fuco_unit_t *unit, char *filename, bool threaded_lexer) {
+    unit->filename = filename;
+    fuco_lexer_init(&unit->lexer);
+    fuco_parser_init(&unit->parser);
+    unit->root = NULL;
+    unit->n_tokens = 0;
+    unit->threaded_lexer = threaded_lexer;
+}
+
+void fuco_unit_destruct(fuco_unit_t *unit) {
+    fuco_lexer_destruct(&unit->lexer);
+    fuco_parser_destruct(&unit->parser);
+
+    if (unit->root != NULL) {
+        fuco_node_free(unit->root);
+    }
+}
+
+void fuco_unit_parse(void *arg) {
+    fuco_unit_t *unit = arg;
+    fuco_tokenring_t ring;
+
+    fuco_lexer_add_job(&unit->lexer, unit->filename);
+
+    if (fuco_tokenring_init(&ring, &unit->lexer, unit->threaded_lexer)) {
+        return;
+    }
+
+    fuco_parser_set_ring(&unit->parser, &ring);
+
+    unit->root = fuco_parse_filebody(&unit->parser);
+
+    fuco_tokenring_destruct(&ring);
+
+    unit->n_tokens = ring.tail;
+}
+
+void fuco_compiler_init(fuco_compiler_t *compiler) {
+    compiler->cap_units = FUCO_COMPILER_UNITS_INIT_SIZE;
+    compiler->units = malloc(compiler->cap_units * sizeof(fuco_unit_t));
+    compiler->n_units = 0;
     fuco_symboltable_init(&compiler->table);
     fuco_ir_init(&compiler->ir);
     fuco_bytecode_init(&compiler->bytecode);
     compiler->root = NULL;
-    compiler->filename = filename;
+    compiler->n_threads = 0;
+    compiler->threaded_lexer = false;
+    compiler->emit = FUCO_EMIT_NONE;
+    compiler->report = NULL;
 }
 
 void fuco_compiler_destruct(fuco_compiler_t *compiler) {
-    fuco_lexer_destruct(&compiler->lexer);
-    fuco_parser_destruct(&compiler->parser);
     fuco_symboltable_destruct(&compiler->table);
     fuco_ir_destruct(&compiler->ir);
     fuco_bytecode_destruct(&compiler->bytecode);
@@ -23,43 +80,193 @@ void fuco_compiler_destruct(fuco_compiler_t *compiler) {
     if (compiler->root != NULL) {
         fuco_node_free(compiler->root);
     }
+
+    for (size_t i = 0; i < compiler->n_units; i++) {
+        fuco_unit_destruct(&compiler->units[i]);
+    }
+
+    free(compiler->units);
+
+    /* Tokens of the units refer to the files by id */
+    fuco_sourcefiles_destruct();
+}
+
+void fuco_compiler_add_file(fuco_compiler_t *compiler, char *filename) {
+    if (compiler->n_units >= compiler->cap_units) {
+        compiler->cap_units *= 2;
+        compiler->units = realloc(compiler->units, 
+                                  compiler->cap_units * sizeof(fuco_unit_t));
+    }
+
+    fuco_unit_init(&compiler->units[compiler->n_units], filename, 
+                   compiler->threaded_lexer);
+    compiler->n_units++;
 }
 
-int fuco_compiler_run(fuco_compiler_t *compiler) {
-    fuco_lexer_add_job(&compiler->lexer, compiler->filename);
+int fuco_compiler_parse_units(fuco_compiler_t *compiler) {
+    fuco_threadpool_t pool;
+    size_t n_threads = compiler->n_threads;
+    int error = 0;
 
-    fuco_tstream_t tstream = fuco_lexer_lex(&compiler->lexer);
-    
-    if (tstream == NULL) {
-        return 1;
+    if (n_threads == 0) {
+        n_threads = fuco_threadpool_default_size();
     }
-    
-    compiler->parser.tstream = tstream;
-    fuco_parser_setup_instrs(&compiler->parser);
 
-    compiler->root = fuco_parse_filebody(&compiler->parser);
-    if (compiler->root == NULL) {
-        return 1;
+    /* Even a single file is parsed on a worker, which has a large enough 
+       stack for FUCO_PARSER_MAX_DEPTH. If no worker starts, the files are 
+       parsed inline with nesting limited to the stack of this thread */
+    n_threads = FUCO_MIN(n_threads, compiler->n_units);
+    if (n_threads == 0) {
+        n_threads = 1;
     }
 
-    fuco_node_setup_scopes(compiler->root, NULL);
+    fuco_threadpool_init(&pool, n_threads);
 
-    fuco_scope_t *global = fuco_node_get_scope(compiler->root, NULL);
+    size_t stack_size = fuco_threadpool_stack_size(&pool);
+
+    for (size_t i = 0; i < compiler->n_units; i++) {
+        fuco_parser_set_stack(&compiler->units[i].parser, stack_size);
+        fuco_threadpool_submit(&pool, fuco_unit_parse, &compiler->units[i]);
+    }
+
+    fuco_threadpool_destruct(&pool);
 
-    fuco_symboltable_setup(&compiler->table, global);
+    size_t allocated;
+    fuco_node_t *root = fuco_node_variadic_new(FUCO_NODE_FILEBODY, &allocated);
+
+    for (size_t i = 0; i < compiler->n_units; i++) {
+        fuco_unit_t *unit = &compiler->units[i];
+
+        if (unit->root == NULL) {
+            error = 1;
+            continue;
+        }
+
+        for (size_t j = 0; j < unit->root->count; j++) {
+            root = fuco_node_add_child(root, unit->root->children[j], 
+                                       &allocated);
+        }
+
+        unit->root->count = 0; /* Children moved to root */
+        fuco_node_free(unit->root);
+        unit->root = NULL;
+    }
+
+    compiler->root = root;
+
+    return error;
+}
+
+int fuco_compiler_generate(fuco_compiler_t *compiler) {
+    fuco_threadpool_t pool;
+    size_t n_threads = compiler->n_threads;
+    int error = 0;
+    size_t n_ranges = (compiler->ir.size + FUCO_IR_RANGE_SIZE - 1) 
+                      / FUCO_IR_RANGE_SIZE;
+
+    if (n_threads == 0) {
+        n_threads = fuco_threadpool_default_size();
+    }
 
-    if (fuco_node_gather_datatypes(compiler->root, &compiler->table, NULL)) {
+    n_threads = FUCO_MIN(n_threads, n_ranges);
+    if (n_threads <= 1) {
+        n_threads = 0;
+    }
+
+    /* Each phase joins its own workers, so their hardware counters are 
+       folded into the phase before it ends */
+    fuco_report_begin(compiler->report);
+    fuco_threadpool_init(&pool, n_threads);
+
+    if (fuco_ir_generate(&compiler->ir, &compiler->table, &pool)) {
+        error = 1;
+    }
+
+    fuco_threadpool_destruct(&pool);
+    fuco_report_end(compiler->report, FUCO_PHASE_GENERATE);
+
+    if (!error) {
+        fuco_report_begin(compiler->report);
+        fuco_threadpool_init(&pool, n_threads);
+        fuco_ir_assemble(&compiler->ir, &compiler->bytecode, &pool);
+        fuco_threadpool_destruct(&pool);
+        fuco_report_end(compiler->report, FUCO_PHASE_ASSEMBLE);
+    }
+
+    return error;
+}
+
+int fuco_compiler_write_tokens(fuco_compiler_t *compiler, FILE *file) {
+    for (size_t i = 0; i < compiler->n_units; i++) {
+        fuco_lexer_t lexer;
+        fuco_lexer_init(&lexer);
+        fuco_lexer_add_job(&lexer, compiler->units[i].filename);
+
+        fuco_tstream_t tstream = fuco_lexer_lex(&lexer);
+
+        if (tstream != NULL) {
+            fuco_tstream_write(tstream, file);
+        }
+
+        fuco_lexer_destruct(&lexer);
+
+        if (tstream == NULL) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void fuco_compiler_count(fuco_compiler_t *compiler, fuco_report_t *report) {
+    report->n_tokens = 0;
+    for (size_t i = 0; i < compiler->n_units; i++) {
+        report->n_tokens += compiler->units[i].n_tokens;
+    }
+
+    /* The file bodies of the units are merged into a single root */
+    report->n_nodes = 1;
+    for (size_t i = 0; i < compiler->n_units; i++) {
+        report->n_nodes += compiler->units[i].parser.n_nodes - 1;
+    }
+    report->n_symbols = compiler->table.size;
+
+    report->n_ir_units = 0;
+    for (size_t i = 0; i < compiler->ir.size; i++) {
+        report->n_ir_units += compiler->ir.objects[i].size;
+    }
+
+    report->n_bytecode_words = compiler->bytecode.size;
+}
+
+int fuco_compiler_run(fuco_compiler_t *compiler) {
+    fuco_report_t *report = compiler->report;
+    int error;
+
+    if ((compiler->emit & FUCO_EMIT_TOKENS) 
+        && fuco_compiler_write_tokens(compiler, stdout)) {
         return 1;
     }
 
-    if (fuco_node_gather_functions(compiler->root, &compiler->table, NULL)) {
+    fuco_report_begin(report);
+    error = fuco_compiler_parse_units(compiler);
+    fuco_report_end(report, FUCO_PHASE_PARSE);
+
+    if (error) {
         return 1;
     }
 
-    if (fuco_node_resolve_local(compiler->root, &compiler->table, NULL, NULL)) {
+    fuco_report_begin(report);
+
+    if (fuco_node_gather_globals(compiler->root, &compiler->table)) {
         return 1;
     }
 
+    fuco_scope_t *global = fuco_node_get_scope(compiler->root, NULL);
+
+    fuco_conversion_table_setup(&compiler->table.conversions, 
+                                &compiler->table, global);
+
     fuco_symbol_t *entry;
     if ((entry = fuco_scope_lookup(global, "main", NULL, false)) == NULL) {
         fuco_syntax_error(NULL, "entry point '%s' was not defined", "main");
@@ -68,24 +275,39 @@ int fuco_compiler_run(fuco_compiler_t *compiler) {
 
     compiler->ir.label = compiler->table.size;
     fuco_ir_create_startup_object(&compiler->ir, entry->id);
-    fuco_node_generate_ir(compiler->root, &compiler->ir, 0);
-    
-    fuco_ir_assemble(&compiler->ir, &compiler->bytecode);
+    fuco_node_create_objects(compiler->root, &compiler->ir);
+
+    fuco_report_end(report, FUCO_PHASE_DECLARE);
+
+    error = fuco_compiler_generate(compiler);
+
+    if (report != NULL) {
+        fuco_compiler_count(compiler, report);
+    }
+
+    if (error) {
+        return 1;
+    }
 
     if (compiler->bytecode.instrs == NULL) {
         return 1;
     }
-    
-    fuco_node_unparse_write(compiler->root, stderr);
-    fprintf(stderr, "\n");
 
-    fuco_node_pretty_write(compiler->root, stderr);
+    if (compiler->emit & FUCO_EMIT_AST) {
+        fuco_node_pretty_write(compiler->root, stdout);
+    }
 
-    fuco_symboltable_write(&compiler->table, stderr);
+    if (compiler->emit & FUCO_EMIT_SYMBOLS) {
+        fuco_symboltable_write(&compiler->table, stdout);
+    }
 
-    fuco_ir_write(&compiler->ir, stderr);
+    if (compiler->emit & FUCO_EMIT_IR) {
+        fuco_ir_write(&compiler->ir, stdout);
+    }
 
-    fuco_bytecode_write(&compiler->bytecode, stderr);
+    if (compiler->emit & FUCO_EMIT_BYTECODE) {
+        fuco_bytecode_write(&compiler->bytecode, stdout);
+    }
 
     return 0;
 }
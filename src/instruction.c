@@ -253,9 +253,20 @@ void fuco_bytecode_add_instr(fuco_bytecode_t *bytecode, fuco_instr_t instr) {
         } else {
             bytecode->cap *= 2;
         }
-        bytecode->instrs = realloc(bytecode->instrs, bytecode->cap);
+        bytecode->instrs = realloc(bytecode->instrs, 
+                                   bytecode->cap * sizeof(fuco_instr_t));
     }
 
     bytecode->instrs[bytecode->size] = instr;
     bytecode->size++;
 }
+
+void fuco_bytecode_resize(fuco_bytecode_t *bytecode, size_t size) {
+    if (size > bytecode->cap) {
+        bytecode->cap = size;
+        bytecode->instrs = realloc(bytecode->instrs, 
+                                   bytecode->cap * sizeof(fuco_instr_t));
+    }
+
+    bytecode->size = size;
+}
@@ -1,11 +1,137 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "interpreter.h"
+#include "profiler.h"
+#include "trace.h"
 #include "utils.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include <time.h>
 #include <stddef.h>
 
+void fuco_vm_stats_init(fuco_vm_stats_t *stats, size_t n_addresses) {
+    memset(stats, 0, sizeof(fuco_vm_stats_t));
+    stats->calls = calloc(n_addresses, sizeof(uint64_t));
+    stats->n_addresses = n_addresses;
+}
+
+void fuco_vm_stats_destruct(fuco_vm_stats_t *stats) {
+    free(stats->calls);
+}
+
+void fuco_vm_stats_record(fuco_vm_stats_t *stats, fuco_program_t *program, 
+                          fuco_opcode_t prev, fuco_instr_t instr) {
+    fuco_opcode_t opcode = FUCO_GET_OPCODE(instr);
+
+    stats->n_instrs++;
+    stats->opcodes[opcode]++;
+    stats->pairs[prev][opcode]++;
+
+    if (opcode == FUCO_OPCODE_CALL) {
+        uint64_t target = FUCO_GET_IMM48(instr);
+
+        if (target < stats->n_addresses) {
+            stats->calls[target]++;
+        }
+
+        stats->depth++;
+        if (stats->depth > stats->max_depth) {
+            stats->max_depth = stats->depth;
+        }
+    } else if (opcode == FUCO_OPCODE_QRET && stats->depth > 0) {
+        stats->depth--;
+    }
+
+    if (program->sp > stats->max_sp) {
+        stats->max_sp = program->sp;
+    }
+}
+
+/* Sorts indices by descending count */
+uint64_t *fuco_vm_stats_sort_counts;
+
+int fuco_vm_stats_compare(void const *left, void const *right) {
+    uint64_t x = fuco_vm_stats_sort_counts[*(size_t const *)left];
+    uint64_t y = fuco_vm_stats_sort_counts[*(size_t const *)right];
+
+    return (x < y) - (x > y);
+}
+
+size_t *fuco_vm_stats_sort(uint64_t *counts, size_t n) {
+    size_t *order = malloc(n * sizeof(size_t));
+
+    for (size_t i = 0; i < n; i++) {
+        order[i] = i;
+    }
+
+    fuco_vm_stats_sort_counts = counts;
+    qsort(order, n, sizeof(size_t), fuco_vm_stats_compare);
+
+    return order;
+}
+
+void fuco_vm_stats_write(fuco_vm_stats_t *stats, fuco_ir_t *ir, FILE *file) {
+    double total = stats->n_instrs > 0 ? stats->n_instrs : 1;
+
+    fprintf(file, "instructions %lu, max call depth %zu, "
+            "stack high-water %lu bytes\n", stats->n_instrs, 
+            stats->max_depth, stats->max_sp);
+
+    size_t *order = fuco_vm_stats_sort(stats->opcodes, FUCO_OPCODES_N);
+
+    fprintf(file, "\n%-10s %14s %7s\n", "opcode", "count", "%");
+    for (size_t i = 0; i < FUCO_OPCODES_N; i++) {
+        uint64_t count = stats->opcodes[order[i]];
+
+        if (count > 0) {
+            fprintf(file, "%-10s %14lu %6.2f%%\n", 
+                    fuco_opcode_get_mnemonic(order[i]), count, 
+                    count / total * 100);
+        }
+    }
+
+    free(order);
+
+    size_t n_pairs = FUCO_OPCODES_N * FUCO_OPCODES_N;
+    order = fuco_vm_stats_sort(&stats->pairs[0][0], n_pairs);
+
+    fprintf(file, "\n%-21s %14s %7s\n", "pair", "count", "%");
+    for (size_t i = 0; i < n_pairs && i < FUCO_VM_STATS_TOP_PAIRS; i++) {
+        uint64_t count = (&stats->pairs[0][0])[order[i]];
+
+        if (count > 0) {
+            fprintf(file, "%-10s %-10s %14lu %6.2f%%\n", 
+                    fuco_opcode_get_mnemonic(order[i] / FUCO_OPCODES_N), 
+                    fuco_opcode_get_mnemonic(order[i] % FUCO_OPCODES_N),
+                    count, count / total * 100);
+        }
+    }
+
+    free(order);
+
+    order = fuco_vm_stats_sort(stats->calls, stats->n_addresses);
+
+    fprintf(file, "\n%14s  %s\n", "calls", "function");
+    for (size_t i = 0; i < stats->n_addresses; i++) {
+        uint64_t count = stats->calls[order[i]];
+        fuco_ir_object_t *object = fuco_ir_object_at(ir, order[i]);
+
+        if (count == 0) {
+            break;
+        }
+
+        fprintf(file, "%14lu  ", count);
+        if (object != NULL) {
+            fuco_ir_object_write_name(object, file);
+        } else {
+            fprintf(file, "%zu", order[i]);
+        }
+        fprintf(file, "\n");
+    }
+
+    free(order);
+}
+
 void fuco_program_pop(fuco_program_t *program, void *data, size_t size) {
     program->sp -= size;
     memcpy(data, program->stack + program->sp, size);
@@ -31,6 +157,7 @@ void fuco_program_init(fuco_program_t *program, fuco_instr_t *instrs,
     program->ip = program->sp = program->bp = 0;
     program->instrs = instrs;
     program->stack = malloc(stack_size);
+    program->trace = NULL;
 }
 
 void fuco_program_destruct(fuco_program_t *program) {
@@ -48,9 +175,9 @@ void fuco_program_write_stack(fuco_program_t *program, FILE *file) {
     }
 }
 
-int32_t fuco_interpret(fuco_instr_t *instrs) {  
+int32_t fuco_interpret(fuco_instr_t *instrs, fuco_vm_hooks_t *hooks) {  
     fuco_program_t program;
-    fuco_program_init(&program, instrs, 4096);
+    fuco_program_init(&program, instrs, FUCO_PROGRAM_STACK_SIZE);
 
     uint64_t retaddr, retbp;
     uint64_t retq;
@@ -59,15 +186,32 @@ int32_t fuco_interpret(fuco_instr_t *instrs) {
     uint64_t x1, x2;
     double f1;
 
-    uint64_t instr_count = 0;
     bool running = true;
 
+    fuco_vm_stats_t *stats = hooks == NULL ? NULL : hooks->stats;
+    fuco_profiler_t *profiler = hooks == NULL ? NULL : hooks->profiler;
+
+    if (hooks != NULL) {
+        program.trace = hooks->trace;
+    }
+
     FUCO_UNUSED(retaddr), FUCO_UNUSED(retbp);
 
-    fprintf(stderr, "Start of execution...\n");
-    clock_t start = clock();
+#ifdef FUCO_VM_STATS
+    fuco_opcode_t prev = FUCO_OPCODE_NOP;
+#else
+    FUCO_UNUSED(stats);
+#endif
 
     while (running) {
+        if (fuco_profiler_pending) {
+            fuco_profiler_pending = 0;
+            if (profiler != NULL) {
+                fuco_profiler_sample(profiler, program.ip, program.bp, 
+                                     program.stack);
+            }
+        }
+
         fuco_instr_t instr = program.instrs[program.ip];
         fuco_opcode_t opcode = instr & 0xFFFF;
 
@@ -80,6 +224,9 @@ int32_t fuco_interpret(fuco_instr_t *instrs) {
                 break;
 
             case FUCO_OPCODE_CALL:
+                if (program.trace != NULL) {
+                    fuco_trace_record(program.trace, program.ip, program.sp);
+                }
                 fuco_program_qpush(&program, program.ip);
                 fuco_program_qpush(&program, program.bp);
                 program.bp = program.sp;
@@ -87,6 +234,9 @@ int32_t fuco_interpret(fuco_instr_t *instrs) {
                 break;
 
             case FUCO_OPCODE_QRET:
+                if (program.trace != NULL) {
+                    fuco_trace_record(program.trace, program.ip, program.sp);
+                }
                 retq = fuco_program_qpop(&program);
                 program.sp = program.bp;
                 program.bp = fuco_program_qpop(&program);
@@ -110,17 +260,28 @@ int32_t fuco_interpret(fuco_instr_t *instrs) {
                 break;
 
             case FUCO_OPCODE_JUMP:
+                if (program.trace != NULL) {
+                    fuco_trace_record(program.trace, program.ip, program.sp);
+                }
                 program.ip = immq - 1;
                 break;
 
             case FUCO_OPCODE_BRTRUE:
                 if (fuco_program_qpop(&program) != 0) {
+                    if (program.trace != NULL) {
+                        fuco_trace_record(program.trace, program.ip, 
+                                          program.sp);
+                    }
                     program.ip = immq - 1;
                 }
                 break;
 
             case FUCO_OPCODE_BRFALSE:
                 if (fuco_program_qpop(&program) == 0) {
+                    if (program.trace != NULL) {
+                        fuco_trace_record(program.trace, program.ip, 
+                                          program.sp);
+                    }
                     program.ip = immq - 1;
                 }
                 break;
@@ -218,18 +379,16 @@ int32_t fuco_interpret(fuco_instr_t *instrs) {
 #endif
         }
 
+#ifdef FUCO_VM_STATS
+        if (stats != NULL) {
+            fuco_vm_stats_record(stats, &program, prev, instr);
+            prev = opcode;
+        }
+#endif
+
         program.ip++;
-        instr_count++;
     }
 
-    clock_t end = clock();    
-    double time = (double)(end - start) / CLOCKS_PER_SEC;
-
-    fprintf(stderr, "Executed %ld instructions in %f seconds"
-            " at %lld instructions per second\n",
-            instr_count, time, (long long)(instr_count / time));
-    fprintf(stderr, "Program finished with exit code %ld\n", exit_code);
-
     fuco_program_destruct(&program);
 
     return exit_code;
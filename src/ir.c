@@ -27,6 +27,10 @@ void fuco_ir_object_init(fuco_ir_object_t *object, fuco_node_t *def) {
     object->size = 0;
     object->def = def;
     object->paramsize_label = 0;
+    object->n_labels = 0;
+    object->label_base = 0;
+    object->n_instrs = 0;
+    object->address = 0;
 }
 
 void fuco_ir_object_destruct(fuco_ir_object_t *object) {
@@ -48,6 +52,132 @@ void fuco_ir_object_write(fuco_ir_object_t *object, FILE *file) {
     fprintf(file, "}\n");
 }
 
+void fuco_ir_object_write_name(fuco_ir_object_t *object, FILE *file) {
+    if (object->def == NULL) {
+        fprintf(file, "<startup>");
+        return;
+    }
+
+    fuco_token_t *token = object->def->token;
+
+    fprintf(file, "%s (", fuco_token_string(token));
+    fuco_textsource_write(&token->source, file);
+    fprintf(file, ")");
+}
+
+bool fuco_ir_object_falls_through(fuco_ir_object_t *object, size_t i, 
+                                  fuco_ir_label_t label) {
+    for (; i < object->size; i++) {
+        fuco_ir_unit_t *unit = &object->units[i];
+
+        if (unit->attrs & FUCO_IR_INSTR) {
+            return false;
+        }
+        if (unit->imm.label == label) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void fuco_ir_object_optimize(fuco_ir_object_t *object) {
+    size_t size = 0;
+
+    for (size_t i = 0; i < object->size; i++) {
+        fuco_ir_unit_t *unit = &object->units[i];
+
+        if (unit->attrs & FUCO_IR_INSTR && unit->opcode == FUCO_OPCODE_JUMP
+            && fuco_ir_object_falls_through(object, i + 1, unit->imm.label)) {
+            continue;
+        }
+
+        object->units[size] = *unit;
+        size++;
+    }
+
+    object->size = size;
+}
+
+fuco_ir_label_t fuco_ir_object_relocate_label(fuco_ir_object_t *object, 
+                                              fuco_ir_label_t label) {
+    if (label & FUCO_LABEL_LOCAL) {
+        return object->label_base + (label & ~FUCO_LABEL_LOCAL);
+    }
+
+    return label;
+}
+
+void fuco_ir_object_relocate(fuco_ir_object_t *object) {
+    for (size_t i = 0; i < object->size; i++) {
+        fuco_ir_unit_t *unit = &object->units[i];
+
+        if (!(unit->attrs & FUCO_IR_INSTR) 
+            || unit->attrs & FUCO_IR_REFERENCES_LABEL) {
+            unit->imm.label = fuco_ir_object_relocate_label(object, 
+                                                            unit->imm.label);
+        }
+    }
+
+    object->paramsize_label = 
+        fuco_ir_object_relocate_label(object, object->paramsize_label);
+}
+
+void fuco_ir_object_define_labels(fuco_ir_object_t *object, uint64_t *defs) {
+    size_t jump_location = object->address;
+
+    for (size_t i = 0; i < object->size; i++) {
+        fuco_ir_unit_t *unit = &object->units[i];
+
+        if (unit->attrs & FUCO_IR_INSTR) {
+            jump_location++;
+        } else {
+            assert(defs[unit->imm.label] == FUCO_LABEL_DEF_INVALID);
+
+            defs[unit->imm.label] = jump_location;
+        }
+    }
+}
+
+void fuco_ir_object_emit(fuco_ir_object_t *object, uint64_t *defs, 
+                         fuco_instr_t *instrs) {
+    size_t n = object->address;
+
+    for (size_t i = 0; i < object->size; i++) {
+        fuco_ir_unit_t *unit = &object->units[i];
+
+        if (unit->attrs & FUCO_IR_INSTR) {
+            fuco_instr_t instr = 0;
+            FUCO_SET_OPCODE(instr, unit->opcode);
+
+            uint64_t imm;
+            if (unit->attrs & FUCO_IR_INCLUDES_DATA) {
+                if (unit->attrs & FUCO_IR_REFERENCES_LABEL) {
+                    imm = defs[unit->imm.label];
+
+                    assert(imm != FUCO_LABEL_DEF_INVALID);
+                } else {
+                    imm = unit->imm.data;
+                }
+            } else {
+                imm = 0;
+            }
+
+            switch (fuco_opcode_get_layout(unit->opcode)) {
+                case FUCO_INSTR_LAYOUT_NO_IMM:
+                    break;
+
+                case FUCO_INSTR_LAYOUT_IMM48:
+                    FUCO_SET_IMM48(instr, imm);
+                    break;
+            }
+
+            instrs[n] = instr;
+            n++;
+        }
+    }
+}
+
 void fuco_ir_init(fuco_ir_t *ir) {
     ir->cap = FUCO_IR_OBJECTS_INIT_SIZE;
     ir->objects = malloc(ir->cap * sizeof(fuco_ir_object_t));
@@ -71,10 +201,39 @@ void fuco_ir_write(fuco_ir_t *ir, FILE *file) {
     }
 }
 
-fuco_ir_label_t fuco_ir_next_label(fuco_ir_t *ir) {
-    fuco_ir_label_t label = ir->label;
+fuco_ir_object_t *fuco_ir_object_at(fuco_ir_t *ir, size_t address) {
+    size_t low = 0, high = ir->size;
+
+    /* Objects are assembled in order, find the last starting at or before 
+       address */
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+
+        if (ir->objects[mid].address <= address) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low == 0) {
+        return NULL;
+    }
+
+    fuco_ir_object_t *object = &ir->objects[low - 1];
+
+    if (address >= object->address + object->n_instrs) {
+        return NULL;
+    }
+
+    return object;
+}
+
+fuco_ir_label_t fuco_ir_next_label(fuco_ir_t *ir, size_t obj) {
+    fuco_ir_object_t *object = &ir->objects[obj];
+    fuco_ir_label_t label = FUCO_LABEL_LOCAL | object->n_labels;
     
-    ir->label++;
+    object->n_labels++;
 
     return label;
 }
@@ -91,7 +250,7 @@ size_t fuco_ir_add_object(fuco_ir_t *ir, fuco_ir_label_t label,
 
     fuco_ir_object_init(&ir->objects[obj], def);
     fuco_ir_add_label(ir, obj, label);
-    ir->objects[obj].paramsize_label = fuco_ir_next_label(ir);
+    ir->objects[obj].paramsize_label = fuco_ir_next_label(ir, obj);
 
     ir->size++;
 
@@ -163,80 +322,185 @@ void fuco_ir_create_startup_object(fuco_ir_t *ir, fuco_ir_label_t entry) {
     fuco_ir_add_instr(ir, obj, FUCO_OPCODE_EXIT);
 }
 
-void fuco_ir_assemble(fuco_ir_t *ir, fuco_bytecode_t *bytecode) {
-    assert(ir->size > 0);
-    assert(ir->objects[0].def == NULL);
+fuco_ir_range_t *fuco_ir_ranges_new(fuco_ir_t *ir, size_t *n_ranges) {
+    size_t n = (ir->size + FUCO_IR_RANGE_SIZE - 1) / FUCO_IR_RANGE_SIZE;
+    fuco_ir_range_t *ranges = malloc(n * sizeof(fuco_ir_range_t));
+
+    for (size_t i = 0; i < n; i++) {
+        fuco_ir_range_t *range = &ranges[i];
+
+        range->ir = ir;
+        range->start = i * FUCO_IR_RANGE_SIZE;
+        range->end = FUCO_MIN(range->start + FUCO_IR_RANGE_SIZE, ir->size);
+        range->n_labels = 0;
+        range->label_base = 0;
+        range->n_instrs = 0;
+        range->address = 0;
+        range->defs = NULL;
+        range->bytecode = NULL;
+        range->table = NULL;
+        range->error = 0;
+    }
 
-    uint64_t *defs = malloc(ir->label * sizeof(uint64_t));
-    for (size_t i = 0; i < ir->label; i++) {
-        defs[i] = FUCO_LABEL_DEF_INVALID;
+    *n_ranges = n;
+
+    return ranges;
+}
+
+void fuco_ir_ranges_run(fuco_ir_range_t *ranges, size_t n_ranges, 
+                        fuco_threadpool_t *pool, fuco_job_func_t func) {
+    for (size_t i = 0; i < n_ranges; i++) {
+        fuco_threadpool_submit(pool, func, &ranges[i]);
     }
 
-    for (size_t i = 0; i < ir->size; i++) {
-        fuco_ir_object_t *obj = &ir->objects[i];
+    fuco_threadpool_wait(pool);
+}
 
-        if (obj->def != NULL) {
-            size_t paramsize = fuco_node_setup_offsets(obj->def, defs);
-            defs[obj->paramsize_label] = paramsize;
+void fuco_ir_range_generate(void *arg) {
+    fuco_ir_range_t *range = arg;
+    fuco_ir_t *ir = range->ir;
+
+    for (size_t i = range->start; i < range->end; i++) {
+        fuco_ir_object_t *object = &ir->objects[i];
+
+        if (object->def != NULL 
+            && fuco_node_analyze(object->def, range->table, ir, i)) {
+            range->error = 1;
+            return;
         }
+
+        fuco_ir_object_optimize(object);
+
+        range->n_labels += object->n_labels;
     }
+}
 
-    /* First pass: define labels */
-    size_t jump_location = 0;
-    for (size_t i = 0; i < ir->size; i++) {
-        fuco_ir_object_t *object = &ir->objects[i];
+void fuco_ir_range_relocate(void *arg) {
+    fuco_ir_range_t *range = arg;
+    fuco_ir_label_t label = range->label_base;
 
-        for (size_t j = 0; j < object->size; j++) {
-            fuco_ir_unit_t *unit = &object->units[j];
+    for (size_t i = range->start; i < range->end; i++) {
+        fuco_ir_object_t *object = &range->ir->objects[i];
 
-            if (unit->attrs & FUCO_IR_INSTR) {
-                jump_location++;
-            } else {
-                assert(unit->imm.label < ir->label);
-                assert(defs[unit->imm.label] == FUCO_LABEL_DEF_INVALID);
+        object->label_base = label;
+        label += object->n_labels;
+
+        fuco_ir_object_relocate(object);
+    }
+}
+
+void fuco_ir_range_setup(void *arg) {
+    fuco_ir_range_t *range = arg;
+
+    for (size_t i = range->start; i < range->end; i++) {
+        fuco_ir_object_t *object = &range->ir->objects[i];
+
+        if (object->def != NULL) {
+            size_t paramsize = fuco_node_setup_offsets(object->def, 
+                                                       range->defs);
+            range->defs[object->paramsize_label] = paramsize;
+        }
 
-                defs[unit->imm.label] = jump_location;
+        object->n_instrs = 0;
+        for (size_t j = 0; j < object->size; j++) {
+            if (object->units[j].attrs & FUCO_IR_INSTR) {
+                object->n_instrs++;
             }
         }
+
+        range->n_instrs += object->n_instrs;
     }
+}
 
-    /* Second pass: write bytecode */
-    for (size_t i = 0; i < ir->size; i++) {
-        fuco_ir_object_t *object = &ir->objects[i];
+void fuco_ir_range_define_labels(void *arg) {
+    fuco_ir_range_t *range = arg;
+    size_t address = range->address;
 
-        for (size_t j = 0; j < object->size; j++) {
-            fuco_ir_unit_t *unit = &object->units[j];
+    for (size_t i = range->start; i < range->end; i++) {
+        fuco_ir_object_t *object = &range->ir->objects[i];
+
+        object->address = address;
+        address += object->n_instrs;
+
+        fuco_ir_object_define_labels(object, range->defs);
+    }
+}
 
-            if (unit->attrs & FUCO_IR_INSTR) {
-                fuco_instr_t instr = 0;
-                FUCO_SET_OPCODE(instr, unit->opcode);
+void fuco_ir_range_emit(void *arg) {
+    fuco_ir_range_t *range = arg;
 
-                uint64_t imm;
-                if (unit->attrs & FUCO_IR_INCLUDES_DATA) {
-                    if (unit->attrs & FUCO_IR_REFERENCES_LABEL) {
-                        imm = defs[unit->imm.label];
+    for (size_t i = range->start; i < range->end; i++) {
+        fuco_ir_object_emit(&range->ir->objects[i], range->defs, 
+                            range->bytecode->instrs);
+    }
+}
 
-                        assert(imm != FUCO_LABEL_DEF_INVALID);
-                    } else {
-                        imm = unit->imm.data;
-                    }
-                } else {
-                    imm = 0;
-                }
+int fuco_ir_generate(fuco_ir_t *ir, fuco_symboltable_t *table, 
+                     fuco_threadpool_t *pool) {
+    size_t n_ranges;
+    fuco_ir_range_t *ranges = fuco_ir_ranges_new(ir, &n_ranges);
+    int error = 0;
 
-                switch (fuco_opcode_get_layout(unit->opcode)) {
-                    case FUCO_INSTR_LAYOUT_NO_IMM:
-                        break;
+    for (size_t i = 0; i < n_ranges; i++) {
+        ranges[i].table = table;
+    }
 
-                    case FUCO_INSTR_LAYOUT_IMM48:
-                        FUCO_SET_IMM48(instr, imm);
-                        break;
-                }
+    fuco_ir_ranges_run(ranges, n_ranges, pool, fuco_ir_range_generate);
 
-                fuco_bytecode_add_instr(bytecode, instr);
-            }
-        }
+    for (size_t i = 0; i < n_ranges; i++) {
+        error = error || ranges[i].error;
+    }
+
+    if (error) {
+        free(ranges);
+        return 1;
+    }
+
+    /* Global labels are symbol ids, local ones follow in object order */
+    for (size_t i = 0; i < n_ranges; i++) {
+        ranges[i].label_base = ir->label;
+        ir->label += ranges[i].n_labels;
+    }
+
+    fuco_ir_ranges_run(ranges, n_ranges, pool, fuco_ir_range_relocate);
+
+    free(ranges);
+
+    return 0;
+}
+
+void fuco_ir_assemble(fuco_ir_t *ir, fuco_bytecode_t *bytecode, 
+                      fuco_threadpool_t *pool) {
+    assert(ir->size > 0);
+    assert(ir->objects[0].def == NULL);
+
+    uint64_t *defs = malloc(ir->label * sizeof(uint64_t));
+    for (size_t i = 0; i < ir->label; i++) {
+        defs[i] = FUCO_LABEL_DEF_INVALID;
     }
 
+    size_t n_ranges;
+    fuco_ir_range_t *ranges = fuco_ir_ranges_new(ir, &n_ranges);
+
+    for (size_t i = 0; i < n_ranges; i++) {
+        ranges[i].defs = defs;
+        ranges[i].bytecode = bytecode;
+    }
+
+    fuco_ir_ranges_run(ranges, n_ranges, pool, fuco_ir_range_setup);
+
+    size_t address = 0;
+    for (size_t i = 0; i < n_ranges; i++) {
+        ranges[i].address = address;
+        address += ranges[i].n_instrs;
+    }
+
+    fuco_bytecode_resize(bytecode, address);
+
+    /* All labels must be defined before any object is emitted */
+    fuco_ir_ranges_run(ranges, n_ranges, pool, fuco_ir_range_define_labels);
+    fuco_ir_ranges_run(ranges, n_ranges, pool, fuco_ir_range_emit);
+
+    free(ranges);
     free(defs);
 }
@@ -1,6 +1,8 @@
 #include "lexer.h"
 #include "utils.h"
 #include "tokenlist.h"
+#include "charclass.h"
+#include "phash.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -8,41 +10,36 @@
 #include <assert.h>
 
 bool fuco_is_nontoken(int c) {
-    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    return FUCO_CHARCLASS(c, FUCO_CHAR_SPACE);
 }
 
 bool fuco_is_identifier_start(int c) {
-    return isalpha(c) || c == '_';
+    return FUCO_CHARCLASS(c, FUCO_CHAR_IDENTIFIER_START);
 }
 
 bool fuco_is_identifier_continue(int c) {
-    return isalpha(c) || isdigit(c) || c == '_';
+    return FUCO_CHARCLASS(c, FUCO_CHAR_IDENTIFIER_CONTINUE);
 }
 
 bool fuco_is_number_start(int c) {
-    return isdigit(c);
+    return FUCO_CHARCLASS(c, FUCO_CHAR_DIGIT);
 }
 
 bool fuco_is_number_continue(int c) {
-    return isdigit(c);
+    return FUCO_CHARCLASS(c, FUCO_CHAR_DIGIT);
 }
 
 bool fuco_is_operator(int c) {
-    return c == '-' || c == '+' || c == '*' || c == '/'
-        || c == '%' || c == '!' || c == '^' || c == '&'
-        || c == '~' || c == '|' || c == '<' || c == '>'
-        || c == '=';
+    return FUCO_CHARCLASS(c, FUCO_CHAR_OPERATOR);
 }
 
-uint64_t *fuco_parse_integer(char *lexeme) {
+uint64_t *fuco_parse_integer(char const *start, size_t len) {
     uint64_t data = 0;
 
-    while (*lexeme != '\0') {
-        assert(isdigit(*lexeme));
+    for (size_t i = 0; i < len; i++) {
+        assert(isdigit(start[i]));
 
-        data = 10 * data + *lexeme - '0';
-
-        lexeme++;
+        data = 10 * data + start[i] - '0';
     }
 
     uint64_t *p = malloc(sizeof(uint64_t));
@@ -51,34 +48,29 @@ uint64_t *fuco_parse_integer(char *lexeme) {
     return p;
 }
 
-size_t fuco_filebuf_read(fuco_filebuf_t *filebuf, FILE *file) {
-    filebuf->i = 0;
-    filebuf->size = fread(filebuf->data, 1, FUCO_LEXER_FILE_BUF_SIZE, file);
-    filebuf->eof = (filebuf->size == 0);
-
-    return filebuf->size;
-}
-
 void fuco_lexer_init(fuco_lexer_t *lexer) {
-    lexer->filebuf.i = lexer->filebuf.size = 0;
-    lexer->filebuf.eof = true; /* Start at EOF -> 'next' file opened */
+    lexer->cap_files = FUCO_LEXER_FILES_INIT_SIZE;
+    lexer->files = malloc(lexer->cap_files * sizeof(uint32_t));
+    lexer->n_files = 0;
 
-    fuco_strbuf_init(&lexer->strbuf);
+    fuco_strtable_init(&lexer->lexemes);
     fuco_tokenlist_init(&lexer->list);
-    fuco_textsource_init(&lexer->curr, NULL);
     fuco_queue_init(&lexer->jobs);
 
-    lexer->file = NULL;
-    lexer->c = '\0';
+    lexer->file = FUCO_SOURCEFILE_NONE;
+    lexer->data = lexer->p = lexer->end = NULL;
 }
 
 void fuco_lexer_destruct(fuco_lexer_t *lexer) {
-    fuco_strbuf_destruct(&lexer->strbuf);
-    fuco_tokenlist_destruct(&lexer->list);
-
-    if (lexer->file != NULL) {
-        fclose(lexer->file);
+    for (size_t i = 0; i < lexer->n_files; i++) {
+        fuco_sourcefiles_close(lexer->files[i]);
     }
+
+    free(lexer->files);
+
+    fuco_strtable_destruct(&lexer->lexemes);
+    fuco_tokenlist_destruct(&lexer->list);
+    fuco_queue_destruct(&lexer->jobs);
 }
 
 void fuco_lexer_add_job(fuco_lexer_t *lexer, char *filename) {
@@ -87,167 +79,174 @@ void fuco_lexer_add_job(fuco_lexer_t *lexer, char *filename) {
 
 int fuco_lexer_open_next_file(fuco_lexer_t *lexer) {
     assert(!fuco_queue_empty(&lexer->jobs));
-    
-    if (lexer->file != NULL) {
-        fclose(lexer->file);
-    }
 
     char *filename = fuco_queue_dequeue(&lexer->jobs);
-    
-    lexer->file = fopen(filename, "r");
+    uint32_t id = fuco_sourcefiles_open(filename);
 
-    if (lexer->file == NULL) {
-        fuco_syntax_error(NULL, "could not open file: %s", filename);
+    if (id == FUCO_SOURCEFILE_NONE) {
         return 1;
     }
 
-    fuco_textsource_init(&lexer->curr, filename);
+    if (lexer->n_files >= lexer->cap_files) {
+        lexer->cap_files *= 2;
+        lexer->files = realloc(lexer->files, 
+                               lexer->cap_files * sizeof(uint32_t));
+    }
+
+    lexer->files[lexer->n_files] = id;
+    lexer->n_files++;
 
-    lexer->filebuf.i = lexer->filebuf.size = 0;
-    lexer->filebuf.eof = false;
+    fuco_sourcefile_t *file = fuco_sourcefiles_get(id);
 
-    fuco_lexer_next_char(lexer);
+    lexer->file = id;
+    lexer->data = lexer->p = file->data;
+    lexer->end = file->data + file->size;
 
     return 0;
 }
 
-void fuco_lexer_next_char(fuco_lexer_t *lexer) {
-    assert(!lexer->filebuf.eof); /* Handled by caller */
+void fuco_lexer_skip_nontokens(fuco_lexer_t *lexer) {
+    char *p = lexer->p;
+    
+    while (true) {
+        p = fuco_scan_space(p, lexer->end);
 
-    if (lexer->filebuf.size != 0) {
-        lexer->filebuf.i++;
-    }
+        if (p == lexer->end || *p != '#') {
+            break;
+        }
 
-    if (lexer->filebuf.i >= lexer->filebuf.size) {
-        fuco_filebuf_read(&lexer->filebuf, lexer->file);
+        /* Stops at the newline or at an invalid byte, reported as token */
+        p = fuco_scan_comment(p + 1, lexer->end);
     }
 
-    fuco_textsource_next_char(&lexer->curr, lexer->c);
-
-    if (lexer->filebuf.eof) {
-        lexer->c = -1;
-    } else {
-        lexer->c = (unsigned char)lexer->filebuf.data[lexer->filebuf.i];
-    }
+    lexer->p = p;
 }
 
-void fuco_lexer_skip_nontokens(fuco_lexer_t *lexer) {
-    bool comment = false;
-    
-    while (lexer->c != -1) {
-        if (lexer->c == '#') {
-            comment = true;
-        } else if (lexer->c == '\n') {
-            comment = false;
-        } else if (!(comment && isprint(lexer->c)) 
-                   && !fuco_is_nontoken(lexer->c)) {
-            return;
-        }
-
-        fuco_lexer_next_char(lexer);
-    }
+void fuco_lexer_get_source(fuco_lexer_t *lexer, char *start, 
+                           fuco_textsource_t *source) {
+    fuco_textsource_init(source, lexer->file, start - lexer->data);
 }
 
-void fuco_lexer_append_token(fuco_lexer_t *lexer, fuco_tokentype_t type, char *lexeme, void *data) {
-    fuco_token_t *token = fuco_tokenlist_append(&lexer->list);
-    
+/* Token spans from start up to the current position */
+void fuco_lexer_set_token(fuco_lexer_t *lexer, fuco_token_t *token, 
+                          fuco_tokentype_t type, char *start, char *lexeme, 
+                          void *data) {
     token->type = type;
     token->lexeme = lexeme;
     token->data = data;
-    token->source = lexer->start;
-}
+    token->length = lexer->p - start;
 
-fuco_tstream_t fuco_lexer_lex(fuco_lexer_t *lexer) {
-    if (fuco_lexer_open_next_file(lexer)) {
-        return NULL;
-    }
+    fuco_lexer_get_source(lexer, start, &token->source);
+}
 
+int fuco_lexer_next_token(fuco_lexer_t *lexer, fuco_token_t *token) {
+    fuco_textsource_t source;
     fuco_tokentype_t type;
-    char *lexeme;
+    char repr[FUCO_REPR_CHAR_SIZE];
+    char *start, *lexeme;
+    size_t len;
     void *data;
 
-    while (true) {
-        type = FUCO_TOKEN_EMPTY;
+    fuco_token_init(token);
+
+    if (lexer->file == FUCO_SOURCEFILE_NONE) {
+        if (fuco_queue_empty(&lexer->jobs)) {
+            token->type = FUCO_TOKEN_END_OF_SOURCE;
+            return 0;
+        }
 
-        fuco_lexer_skip_nontokens(lexer);
+        if (fuco_lexer_open_next_file(lexer)) {
+            return 1;
+        }
+    }
 
-        lexer->start = lexer->curr;
-        fuco_strbuf_clear(&lexer->strbuf);
+    fuco_lexer_skip_nontokens(lexer);
 
-        if (fuco_is_identifier_start(lexer->c)) {
-            type = FUCO_TOKEN_IDENTIFIER;
+    start = lexer->p;
+
+    if (start == lexer->end) {
+        fuco_lexer_set_token(lexer, token, FUCO_TOKEN_END_OF_FILE, start, 
+                             NULL, NULL);
 
-            do {
-                fuco_strbuf_append_char(&lexer->strbuf, lexer->c);
-                fuco_lexer_next_char(lexer);
-            } while (fuco_is_identifier_continue(lexer->c));
-
-            type = fuco_tokentype_lookup_string(lexer->strbuf.data, 
-                                                FUCO_TOKENKIND_KEYWORD);
-
-            if (type == FUCO_TOKEN_EMPTY) {
-                type = FUCO_TOKEN_IDENTIFIER;
-                lexeme = fuco_strbuf_dup(&lexer->strbuf);
-            } else {
-                lexeme = NULL;
-            }
-            
-            fuco_lexer_append_token(lexer, type, lexeme, NULL);
-        } else if (fuco_is_number_start(lexer->c)) {
-            do {
-                fuco_strbuf_append_char(&lexer->strbuf, lexer->c);
-                fuco_lexer_next_char(lexer);
-            } while (fuco_is_number_continue(lexer->c));
-
-            data = fuco_parse_integer(lexer->strbuf.data);
-            if (data == NULL) {
-                return NULL;
-            }
-
-            lexeme = fuco_strbuf_dup(&lexer->strbuf);
-
-            fuco_lexer_append_token(lexer, FUCO_TOKEN_INTEGER, lexeme, data);
-        } else if (fuco_is_operator(lexer->c)) { /* For now: greedy operators */
-            do {
-                fuco_strbuf_append_char(&lexer->strbuf, lexer->c);
-                fuco_lexer_next_char(lexer);
-            } while (fuco_is_operator(lexer->c));
-
-            type = fuco_tokentype_lookup_string(lexer->strbuf.data, 
-                                                FUCO_TOKENKIND_OPERATOR);
-            
-            if (type == FUCO_TOKEN_EMPTY) {
-                fuco_syntax_error(&lexer->start, "invalid operator: '%s'", 
-                                  lexer->strbuf.data);
-                return NULL;
-            }
-
-            fuco_lexer_append_token(lexer, type, NULL, NULL);
-        } else if (lexer->c == -1) {
-            fuco_lexer_append_token(lexer, FUCO_TOKEN_END_OF_FILE, NULL, NULL);
-
-            if (fuco_queue_empty(&lexer->jobs)) {
-                return fuco_tokenlist_terminate(&lexer->list);
-            } else {
-                if (fuco_lexer_open_next_file(lexer)) {
-                    return NULL;
-                }
-            }
+        lexer->file = FUCO_SOURCEFILE_NONE; /* Open next file on next call */
+
+        return 0;
+    }
+
+    unsigned char c = *lexer->p;
+
+    if (fuco_is_identifier_start(c)) {
+        lexer->p = fuco_scan_identifier(lexer->p + 1, lexer->end);
+
+        len = lexer->p - start;
+        type = fuco_phash_tokentype(start, len, FUCO_TOKENKIND_KEYWORD);
+
+        if (type == FUCO_TOKEN_EMPTY) {
+            type = FUCO_TOKEN_IDENTIFIER;
+            lexeme = fuco_strtable_intern(&lexer->lexemes, start, len);
         } else {
-            fuco_strbuf_append_char(&lexer->strbuf, lexer->c);
+            lexeme = NULL;
+        }
+        
+        fuco_lexer_set_token(lexer, token, type, start, lexeme, NULL);
+    } else if (fuco_is_number_start(c)) {
+        lexer->p = fuco_scan_number(lexer->p + 1, lexer->end);
 
-            fuco_lexer_next_char(lexer);
+        len = lexer->p - start;
 
-            type = fuco_tokentype_lookup_string(lexer->strbuf.data, 
-                                                FUCO_TOKENKIND_SEPARATOR);
+        data = fuco_parse_integer(start, len);
+        if (data == NULL) {
+            return 1;
+        }
+
+        lexeme = fuco_strtable_intern(&lexer->lexemes, start, len);
+
+        fuco_lexer_set_token(lexer, token, FUCO_TOKEN_INTEGER, start, 
+                             lexeme, data);
+    } else if (fuco_is_operator(c)) { /* For now: greedy operators */
+        do {
+            lexer->p++;
+        } while (lexer->p < lexer->end && fuco_is_operator(*lexer->p));
+
+        len = lexer->p - start;
+        type = fuco_phash_tokentype(start, len, FUCO_TOKENKIND_OPERATOR);
+        
+        if (type == FUCO_TOKEN_EMPTY) {
+            fuco_lexer_get_source(lexer, start, &source);
+            fuco_syntax_error(&source, "invalid operator: '%.*s'", 
+                              (int)len, start);
+            return 1;
+        }
+
+        fuco_lexer_set_token(lexer, token, type, start, NULL, NULL);
+    } else {
+        lexer->p++;
 
-            if (type == FUCO_TOKEN_EMPTY) {
-                fuco_syntax_error(&lexer->start, "invalid character: '%s'", 
-                                  fuco_repr_char(lexer->strbuf.data[0]));
-                return NULL;
-            }
+        type = fuco_phash_tokentype(start, 1, FUCO_TOKENKIND_SEPARATOR);
 
-            fuco_lexer_append_token(lexer, type, NULL, NULL);
+        if (type == FUCO_TOKEN_EMPTY) {
+            fuco_lexer_get_source(lexer, start, &source);
+            fuco_syntax_error(&source, "invalid character: '%s'", 
+                              fuco_repr_char(*start, repr));
+            return 1;
         }
+
+        fuco_lexer_set_token(lexer, token, type, start, NULL, NULL);
     }
+
+    return 0;
+}
+
+fuco_tstream_t fuco_lexer_lex(fuco_lexer_t *lexer) {
+    fuco_token_t *token;
+
+    do {
+        token = fuco_tokenlist_append(&lexer->list);
+
+        if (fuco_lexer_next_token(lexer, token)) {
+            return NULL;
+        }
+    } while (token->type != FUCO_TOKEN_END_OF_SOURCE);
+
+    return lexer->list.tokens;
 }
@@ -1,21 +1,404 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
-#include "parser.h"
-#include "symbol.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "interpreter.h"
+#include "profiler.h"
+#include "trace.h"
+#include "aot.h"
+#include "asm.h"
 #include "utils.h"
 #include "compiler.h"
 
-int main(int argc, char *argv[]) {
-    FUCO_UNUSED(argc), FUCO_UNUSED(argv);
+typedef struct {
+    fuco_compiler_t *compiler;
+    bool run;
+    bool help;
+    bool time_report;
+    bool json; /* Write the time report as JSON */
+    bool perf; /* Add hardware counters to the time report */
+    bool vm_stats;
+    char const *profile; /* Folded stacks are written here if not NULL */
+    char const *trace; /* Trace dumps are written here if not NULL */
+    char const *trace_decode; /* Dump to decode instead of compiling */
+    char const *emit_c; /* C translation is written here, "-" for stdout */
+    bool native; /* Run the C translation instead of interpreting */
+    char const *emit_asm; /* Assembly is written here, "-" for stdout */
+    char const *emit_exe; /* Native executable built from the assembly */
+} fuco_options_t;
+
+void fuco_usage_write(char const *name, FILE *file) {
+    fprintf(file,
+            "usage: %s [options] file...\n"
+            "options:\n"
+            "  --emit=<stage>[,<stage>...]\n"
+            "                     write stages to stdout, stage is one of\n"
+            "                     tokens, ast, symbols, ir, bytecode\n"
+            "  --run              interpret the program, its exit code is\n"
+            "                     returned\n"
+            "  --run-native       compile the program to C with cc and run it\n"
+            "                     in process instead of interpreting it\n"
+            "  --emit-c[=<file>]  write the program as C, to stdout by "
+            "default\n"
+            "  --emit-asm[=<file>]\n"
+            "                     write the program as x86-64 assembly, to\n"
+            "                     stdout by default\n"
+            "  --emit-exe=<file>  assemble and link the program with cc\n"
+            "  --threads=<n>      workers per phase, 0 for one per processor\n"
+            "  --threaded-lexer   lex on a separate thread while parsing\n"
+            "  --time-report[=json]\n"
+            "                     write time and memory per phase to stderr\n"
+            "  --perf-counters    add hardware counters to the time report,\n"
+            "                     where perf_event_open is available\n"
+            "  --vm-stats         run and write an execution profile to stderr,\n"
+            "                     requires a build with VM_STATS=1\n"
+            "  --profile=<file>   run and write sampled call stacks to file\n"
+            "                     in folded format\n"
+            "  --trace=<file>     run and dump the last calls, returns and\n"
+            "                     taken branches to file on exit, on a crash\n"
+            "                     and on SIGUSR1\n"
+            "  --trace-decode=<file>\n"
+            "                     write a dump made from the same files\n"
+            "  -h, --help         show this message\n", name);
+}
+
+int fuco_options_parse_emit(fuco_options_t *options, char const *arg) {
+    char const *end;
+
+    do {
+        end = strchr(arg, ',');
+        if (end == NULL) {
+            end = arg + strlen(arg);
+        }
+
+        fuco_emit_t emit = fuco_emit_lookup(arg, end - arg);
+
+        if (emit == FUCO_EMIT_NONE) {
+            fprintf(stderr, "fuco: unknown stage '%.*s'\n",
+                    (int)(end - arg), arg);
+            return 1;
+        }
+
+        options->compiler->emit |= emit;
+        arg = end + 1;
+    } while (*end != '\0');
+
+    return 0;
+}
+
+int fuco_options_parse_threads(fuco_options_t *options, char const *arg) {
+    char *end;
+    long n = strtol(arg, &end, 10);
+
+    if (*arg == '\0' || *end != '\0' || n < 0) {
+        fprintf(stderr, "fuco: invalid thread count '%s'\n", arg);
+        return 1;
+    }
+
+    options->compiler->n_threads = n;
+
+    return 0;
+}
+
+int fuco_options_parse(fuco_options_t *options, int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        char *arg = argv[i];
+
+        if (strncmp(arg, "--emit=", 7) == 0) {
+            if (fuco_options_parse_emit(options, arg + 7)) {
+                return 1;
+            }
+        } else if (strcmp(arg, "--run") == 0) {
+            options->run = true;
+        } else if (strcmp(arg, "--run-native") == 0) {
+            options->run = options->native = true;
+        } else if (strcmp(arg, "--emit-c") == 0) {
+            options->emit_c = "-";
+        } else if (strncmp(arg, "--emit-c=", 9) == 0 && arg[9] != '\0') {
+            options->emit_c = arg + 9;
+        } else if (strcmp(arg, "--emit-asm") == 0) {
+            options->emit_asm = "-";
+        } else if (strncmp(arg, "--emit-asm=", 11) == 0
+                   && arg[11] != '\0') {
+            options->emit_asm = arg + 11;
+        } else if (strncmp(arg, "--emit-exe=", 11) == 0
+                   && arg[11] != '\0') {
+            options->emit_exe = arg + 11;
+        } else if (strncmp(arg, "--threads=", 10) == 0) {
+            if (fuco_options_parse_threads(options, arg + 10)) {
+                return 1;
+            }
+        } else if (strcmp(arg, "--time-report") == 0) {
+            options->time_report = true;
+        } else if (strcmp(arg, "--time-report=json") == 0) {
+            options->time_report = options->json = true;
+        } else if (strcmp(arg, "--perf-counters") == 0) {
+            options->time_report = options->perf = true;
+        } else if (strcmp(arg, "--vm-stats") == 0) {
+#ifdef FUCO_VM_STATS
+            options->run = options->vm_stats = true;
+#else
+            fprintf(stderr, "fuco: --vm-stats requires a build with "
+                    "VM_STATS=1\n");
+            return 1;
+#endif
+        } else if (strncmp(arg, "--profile=", 10) == 0 && arg[10] != '\0') {
+            options->profile = arg + 10;
+            options->run = true;
+        } else if (strncmp(arg, "--trace=", 8) == 0 && arg[8] != '\0') {
+            options->trace = arg + 8;
+            options->run = true;
+        } else if (strncmp(arg, "--trace-decode=", 15) == 0
+                   && arg[15] != '\0') {
+            options->trace_decode = arg + 15;
+        } else if (strcmp(arg, "--threaded-lexer") == 0) {
+            options->compiler->threaded_lexer = true;
+        } else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            options->help = true;
+        } else if (arg[0] == '-') {
+            fprintf(stderr, "fuco: unknown option '%s'\n", arg);
+            return 1;
+        } else {
+            fuco_compiler_add_file(options->compiler, arg);
+        }
+    }
+
+    if (options->compiler->n_units == 0 && !options->help) {
+        fprintf(stderr, "fuco: no input files\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Interprets the compiled program with the requested hooks, returns its
+   exit code */
+int fuco_options_execute(fuco_options_t *options) {
+    fuco_compiler_t *compiler = options->compiler;
+    fuco_vm_hooks_t hooks = { NULL, NULL, NULL };
+    fuco_vm_stats_t stats;
+    fuco_profiler_t profiler;
+    FILE *profile = NULL;
+    int trace = -1;
+    int status = 1;
+
+    if (options->trace != NULL) {
+        trace = open(options->trace, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (trace == -1) {
+            perror(options->trace);
+            return 1;
+        }
+
+        hooks.trace = malloc(sizeof(fuco_trace_t));
+        fuco_trace_init(hooks.trace);
+
+        if (fuco_trace_install(hooks.trace, trace)) {
+            free(hooks.trace);
+            close(trace);
+            return 1;
+        }
+    }
+
+    if (options->profile != NULL) {
+        fuco_profiler_init(&profiler);
+
+        if ((profile = fopen(options->profile, "w")) == NULL) {
+            perror(options->profile);
+        } else if (fuco_profiler_start(&profiler)) {
+            fclose(profile);
+        } else {
+            hooks.profiler = &profiler;
+        }
+
+        if (hooks.profiler == NULL) {
+            fuco_profiler_destruct(&profiler);
+        }
+    }
+
+    if (options->vm_stats) {
+        fuco_vm_stats_init(&stats, compiler->bytecode.size);
+        hooks.stats = &stats;
+    }
+
+    if (options->profile == NULL || hooks.profiler != NULL) {
+        fuco_report_begin(compiler->report);
+        status = fuco_interpret(compiler->bytecode.instrs, &hooks);
+        fuco_report_end(compiler->report, FUCO_PHASE_EXECUTE);
+    }
+
+    if (hooks.profiler != NULL) {
+        fuco_profiler_stop(&profiler);
+        if (fuco_profiler_write_folded(&profiler, &compiler->ir, profile)) {
+            fprintf(stderr, "fuco: could not write profile\n");
+        }
+
+        fuco_profiler_destruct(&profiler);
+        fclose(profile);
+    }
+
+    if (hooks.stats != NULL) {
+        fuco_vm_stats_write(&stats, &compiler->ir, stderr);
+        fuco_vm_stats_destruct(&stats);
+    }
+
+    if (hooks.trace != NULL) {
+        fuco_trace_uninstall();
+        if (fuco_trace_dump(hooks.trace, trace)) {
+            perror(options->trace);
+        }
 
+        free(hooks.trace);
+        close(trace);
+    }
+
+    return status;
+}
+
+int fuco_options_execute_native(fuco_options_t *options) {
+    fuco_compiler_t *compiler = options->compiler;
+    int32_t status;
+
+    if (fuco_aot_run(&compiler->ir, &compiler->bytecode, &status)) {
+        return 1;
+    }
+
+    return status;
+}
+
+typedef int (*fuco_translate_t)(fuco_ir_t *, fuco_bytecode_t *, FILE *);
+
+/* Writes a translation of the compiled program to path, "-" for stdout */
+int fuco_options_translate(fuco_options_t *options, char const *path,
+                           fuco_translate_t translate) {
+    fuco_compiler_t *compiler = options->compiler;
+    FILE *file = stdout;
+    int error;
+
+    if (strcmp(path, "-") != 0 && (file = fopen(path, "w")) == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    error = translate(&compiler->ir, &compiler->bytecode, file);
+
+    if (file != stdout && fclose(file) != 0) {
+        perror(path);
+        error = 1;
+    }
+
+    return error;
+}
+
+int fuco_options_emit(fuco_options_t *options) {
+    fuco_compiler_t *compiler = options->compiler;
+
+    if (options->emit_c != NULL
+        && fuco_options_translate(options, options->emit_c,
+                                  fuco_aot_write)) {
+        return 1;
+    }
+
+    if (options->emit_asm != NULL
+        && fuco_options_translate(options, options->emit_asm,
+                                  fuco_asm_write)) {
+        return 1;
+    }
+
+    if (options->emit_exe != NULL
+        && fuco_asm_build(&compiler->ir, &compiler->bytecode,
+                          options->emit_exe)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+int fuco_options_decode_trace(fuco_options_t *options) {
+    fuco_compiler_t *compiler = options->compiler;
+    FILE *file = fopen(options->trace_decode, "rb");
+    fuco_trace_t *trace;
+
+    if (file == NULL) {
+        perror(options->trace_decode);
+        return 1;
+    }
+
+    trace = malloc(sizeof(fuco_trace_t));
+
+    if (fuco_trace_read(trace, file)) {
+        fprintf(stderr, "fuco: '%s' is not a trace dump\n",
+                options->trace_decode);
+        free(trace);
+        fclose(file);
+        return 1;
+    }
+
+    fuco_trace_write(trace, &compiler->bytecode, &compiler->ir, stdout);
+
+    free(trace);
+    fclose(file);
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
     fuco_compiler_t compiler;
-    fuco_compiler_init(&compiler, "tests/main.fc");
+    fuco_options_t options = {
+        &compiler, false, false, false, false, false, false, NULL, NULL,
+        NULL, NULL, false, NULL, NULL
+    };
+    fuco_report_t report;
+    fuco_perf_t perf;
+    int status = 0;
+
+    fuco_compiler_init(&compiler);
+    fuco_report_init(&report);
 
-    if (fuco_compiler_run(&compiler) == 0) {
-        fuco_interpret(compiler.bytecode.instrs);
+    if (fuco_options_parse(&options, argc, argv)) {
+        fuco_usage_write(argv[0], stderr);
+        status = 1;
+    } else if (options.help) {
+        fuco_usage_write(argv[0], stdout);
+    } else {
+        if (options.time_report) {
+            compiler.report = &report;
+        }
+
+        /* Opened before any worker is created, so that they inherit the 
+           counters */
+        if (options.perf && fuco_perf_open(&perf) == 0) {
+            fprintf(stderr, "fuco: hardware counters are unavailable\n");
+        } else if (options.perf) {
+            report.perf = &perf;
+        }
+
+        if (fuco_compiler_run(&compiler)) {
+            status = 1;
+        } else if (options.trace_decode != NULL) {
+            status = fuco_options_decode_trace(&options);
+        } else if (fuco_options_emit(&options)) {
+            status = 1;
+        } else if (options.native) {
+            status = fuco_options_execute_native(&options);
+        } else if (options.run) {
+            status = fuco_options_execute(&options);
+        }
+
+        if (options.time_report && options.json) {
+            fuco_report_write_json(&report, stderr);
+        } else if (options.time_report) {
+            fuco_report_write(&report, stderr);
+        }
+
+        if (report.perf != NULL) {
+            fuco_perf_close(&perf);
+        }
     }
 
     fuco_compiler_destruct(&compiler);
 
-    return 0;
+    return status;
 }
@@ -1,7 +1,9 @@
 #include "parser.h"
 #include "utils.h"
 #include "strutils.h"
+#include "phash.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 fuco_operator_specification_t fuco_operator_specs[] = {
@@ -19,55 +21,144 @@ fuco_operator_specification_t fuco_operator_specs[] = {
     }
 };
 
+fuco_operator_binding_t fuco_operator_bindings[FUCO_N_TOKENTYPES];
+
+pthread_once_t fuco_operator_bindings_once = PTHREAD_ONCE_INIT;
+
+fuco_opcode_t fuco_instr_opcodes[FUCO_INSTR_OPCODES_N] = {
+    FUCO_OPCODE_IADD,
+    FUCO_OPCODE_ISUB,
+    FUCO_OPCODE_IMUL,
+    FUCO_OPCODE_IDIV,
+    FUCO_OPCODE_IMOD,
+    FUCO_OPCODE_IEQ,
+    FUCO_OPCODE_INE,
+    FUCO_OPCODE_ILT,
+    FUCO_OPCODE_ILE,
+    FUCO_OPCODE_IGT,
+    FUCO_OPCODE_IGE,
+    FUCO_OPCODE_ITOF,
+    FUCO_OPCODE_FTOI
+};
+
+void fuco_operator_bindings_setup(void) {
+    for (size_t level = 0; level < FUCO_ARRAY_SIZE(fuco_operator_specs); 
+         level++) {
+        fuco_operator_specification_t *spec = &fuco_operator_specs[level];
+        uint8_t power = 2 * level + 1;
+
+        for (size_t i = 0; i < FUCO_MAX_OPERATORS_PER_LEVEL; i++) {
+            fuco_operator_binding_t *binding 
+                = &fuco_operator_bindings[spec->operators[i]];
+
+            if (spec->operators[i] == FUCO_TOKEN_NULL) {
+                continue;
+            }
+
+            if (spec->associativity == FUCO_ASSOCIATIVE_LEFT) {
+                binding->left = power;
+                binding->right = power + 1;
+            } else {
+                binding->left = power + 1;
+                binding->right = power;
+            }
+        }
+    }
+}
+
 void fuco_parser_init(fuco_parser_t *parser) {
+    pthread_once(&fuco_operator_bindings_once, fuco_operator_bindings_setup);
+
     parser->tstream = NULL;
-    fuco_map_init(&parser->instrs, fuco_string_hash, fuco_string_equal, 
-                  NULL, NULL);
+    parser->ring = NULL;
+    fuco_tokenarena_init(&parser->pinned);
+    parser->pinned_current = NULL;
+    parser->depth = 0;
+    parser->max_depth = FUCO_PARSER_MAX_DEPTH;
+    parser->n_nodes = 0;
 }
 
 void fuco_parser_destruct(fuco_parser_t *parser) {
-    fuco_map_destruct(&parser->instrs);
+    fuco_tokenarena_destruct(&parser->pinned);
 }
 
-void fuco_parser_setup_instrs(fuco_parser_t *parser) {
-    static fuco_opcode_t instrs[] = {
-        FUCO_OPCODE_IADD,
-        FUCO_OPCODE_ISUB,
-        FUCO_OPCODE_IMUL,
-        FUCO_OPCODE_IDIV,
-        FUCO_OPCODE_IMOD,
-        FUCO_OPCODE_IEQ,
-        FUCO_OPCODE_INE,
-        FUCO_OPCODE_ILT,
-        FUCO_OPCODE_ILE,
-        FUCO_OPCODE_IGT,
-        FUCO_OPCODE_IGE,
-        FUCO_OPCODE_ITOF,
-        FUCO_OPCODE_FTOI
-    };
-
-    for (size_t i = 0; i < sizeof(instrs) / sizeof(*instrs); i++) {
-        char *mnemonic = fuco_opcode_get_mnemonic(instrs[i]);
-        void **result = fuco_map_insert(&parser->instrs, mnemonic, &instrs[i]);
-
-        assert(result == NULL);
+void fuco_parser_set_ring(fuco_parser_t *parser, fuco_tokenring_t *ring) {
+    parser->ring = ring;
+    parser->tstream = fuco_tokenring_peek(ring);
+    parser->pinned_current = NULL;
+}
+
+void fuco_parser_set_stack(fuco_parser_t *parser, size_t stack_size) {
+    parser->max_depth = FUCO_MIN(stack_size / FUCO_PARSER_DEPTH_STACK, 
+                                 FUCO_PARSER_MAX_DEPTH);
+}
+
+fuco_token_t *fuco_parser_pin(fuco_parser_t *parser) {
+    if (parser->ring == NULL) {
+        return parser->tstream;
     }
+
+    if (parser->pinned_current == NULL) {
+        parser->pinned_current = fuco_tokenarena_add(&parser->pinned, 
+                                                     parser->tstream);
+    }
+
+    return parser->pinned_current;
 }
 
-fuco_token_t *fuco_parser_advance(fuco_parser_t *parser) {
-    fuco_token_t *last = parser->tstream;
+void fuco_parser_advance(fuco_parser_t *parser) {
+    if (parser->tstream->type == FUCO_TOKEN_END_OF_SOURCE 
+        || parser->tstream->type == FUCO_TOKEN_ERROR) {
+        return;
+    }
 
-    if (parser->tstream->type != FUCO_TOKEN_END_OF_SOURCE) {
+    if (parser->ring != NULL) {
+        fuco_tokenring_release(parser->ring);
+        parser->tstream = fuco_tokenring_peek(parser->ring);
+        parser->pinned_current = NULL;
+    } else {
         parser->tstream++;
     }
+}
+
+bool fuco_parser_enter(fuco_parser_t *parser) {
+    if (parser->depth >= parser->max_depth) {
+        fuco_syntax_error(&parser->tstream->source, 
+                          "nesting exceeds maximum depth of %zu", 
+                          parser->max_depth);
+        return false;
+    }
+
+    parser->depth++;
+
+    return true;
+}
+
+void fuco_parser_leave(fuco_parser_t *parser) {
+    assert(parser->depth > 0);
+
+    parser->depth--;
+}
+
+fuco_node_t *fuco_parser_node_new(fuco_parser_t *parser, 
+                                  fuco_nodetype_t type) {
+    parser->n_nodes++;
+
+    return fuco_node_new(type);
+}
+
+fuco_node_t *fuco_parser_variadic_new(fuco_parser_t *parser, 
+                                      fuco_nodetype_t type, 
+                                      size_t *allocated) {
+    parser->n_nodes++;
 
-    return last;
+    return fuco_node_variadic_new(type, allocated);
 }
 
 void fuco_parser_move(fuco_parser_t *parser, fuco_node_t *node) {
     assert(node->token == NULL);
 
-    node->token = parser->tstream;
+    node->token = fuco_parser_pin(parser);
 }
 
 bool fuco_parser_accept(fuco_parser_t *parser, fuco_tokentype_t type, 
@@ -85,12 +176,19 @@ bool fuco_parser_accept(fuco_parser_t *parser, fuco_tokentype_t type,
     return true;
 }
 
+void fuco_parser_unexpected(fuco_parser_t *parser, char *expected) {
+    if (parser->tstream->type == FUCO_TOKEN_ERROR) { /* Already reported */
+        return;
+    }
+
+    fuco_syntax_error(&parser->tstream->source, "expected %s, but got %s", 
+                      expected, fuco_token_string(parser->tstream));
+}
+
 bool fuco_parser_expect(fuco_parser_t *parser, fuco_tokentype_t type, 
                         fuco_node_t *node) {
     if (parser->tstream->type != type) {
-        fuco_syntax_error(&parser->tstream->source, "expected %s, but got %s", 
-                          fuco_tokentype_string(type), 
-                          fuco_token_static_string(parser->tstream));
+        fuco_parser_unexpected(parser, fuco_tokentype_string(type));
 
         return false;
     }
@@ -108,20 +206,16 @@ int fuco_parser_lookup_instr(fuco_parser_t *parser, fuco_node_t *node) {
     assert(parser->tstream->type == FUCO_TOKEN_IDENTIFIER);
     assert(node->type == FUCO_NODE_INSTR);
 
-    char *mnemonic =  fuco_token_string(parser->tstream);
-    void **result = fuco_map_lookup(&parser->instrs, mnemonic);
+    char *mnemonic = fuco_token_string(parser->tstream);
+    fuco_opcode_t opcode = fuco_phash_instr(mnemonic, strlen(mnemonic));
 
-    if (result == NULL) {
+    if (opcode == FUCO_OPCODES_N) {
         fuco_syntax_error(&parser->tstream->source, 
                           "unrecognized instruction: '%s'", mnemonic);
         return 1;
     }
 
-    fuco_opcode_t *mapped_instr = *result;
-
-    assert(mapped_instr != NULL);
-
-    node->opcode = *mapped_instr;
+    node->opcode = opcode;
 
     return 0;
 }
@@ -132,7 +226,8 @@ bool fuco_parser_check(fuco_parser_t *parser, fuco_tokentype_t type) {
 
 fuco_node_t *fuco_parse_filebody(fuco_parser_t *parser) {
     size_t allocated;
-    fuco_node_t *node = fuco_node_variadic_new(FUCO_NODE_FILEBODY, &allocated);
+    fuco_node_t *node = fuco_parser_variadic_new(parser, FUCO_NODE_FILEBODY, 
+                                                 &allocated);
 
     fuco_parser_expect(parser, FUCO_TOKEN_START_OF_SOURCE, NULL);
 
@@ -156,7 +251,7 @@ fuco_node_t *fuco_parse_function_declaration(fuco_parser_t *parser) {
         return NULL;
     }
 
-    fuco_node_t *node = fuco_node_new(FUCO_NODE_FUNCTION);
+    fuco_node_t *node = fuco_parser_node_new(parser, FUCO_NODE_FUNCTION);
     fuco_node_t *params = NULL, *body = NULL, *ret_type = NULL;
     bool success = true;
 
@@ -171,9 +266,7 @@ fuco_node_t *fuco_parse_function_declaration(fuco_parser_t *parser) {
         success = fuco_parser_expect(parser, FUCO_TOKEN_SQBRACKET_CLOSE, NULL);
     } else if (!fuco_parser_accept(parser, FUCO_TOKEN_CONVERT, node)
                && !fuco_parser_accept(parser, FUCO_TOKEN_IDENTIFIER, node)) {
-        fuco_syntax_error(&parser->tstream->source, 
-                          "expected function identifier, but got %s", 
-                          fuco_token_static_string(parser->tstream));
+        fuco_parser_unexpected(parser, "function identifier");
         success = false;
     }
 
@@ -201,8 +294,9 @@ fuco_node_t *fuco_parse_function_declaration(fuco_parser_t *parser) {
 
 fuco_node_t *fuco_parse_param_list(fuco_parser_t *parser) {
     size_t allocated;
-    fuco_node_t *node = fuco_node_variadic_new(FUCO_NODE_PARAM_LIST, 
-                                               &allocated);
+    fuco_node_t *node = fuco_parser_variadic_new(parser, 
+                                                 FUCO_NODE_PARAM_LIST, 
+                                                 &allocated);
     fuco_node_t *param = NULL;
     
     if (!fuco_parser_expect(parser, FUCO_TOKEN_BRACKET_OPEN, NULL)) {
@@ -234,7 +328,7 @@ fuco_node_t *fuco_parse_param_list(fuco_parser_t *parser) {
 }
 
 fuco_node_t *fuco_parse_param(fuco_parser_t *parser) {
-    fuco_node_t *node = fuco_node_new(FUCO_NODE_PARAM);
+    fuco_node_t *node = fuco_parser_node_new(parser, FUCO_NODE_PARAM);
     fuco_node_t *type = NULL;
 
     if (!fuco_parser_expect(parser, FUCO_TOKEN_IDENTIFIER, node)
@@ -250,24 +344,29 @@ fuco_node_t *fuco_parse_param(fuco_parser_t *parser) {
 }
 
 fuco_node_t *fuco_parse_braced_block(fuco_parser_t *parser) {
-    if (!fuco_parser_expect(parser, FUCO_TOKEN_BRACE_OPEN, NULL)) {
+    if (!fuco_parser_expect(parser, FUCO_TOKEN_BRACE_OPEN, NULL)
+        || !fuco_parser_enter(parser)) {
         return NULL;
     }
 
     size_t allocated;
-    fuco_node_t *node = fuco_node_variadic_new(FUCO_NODE_BODY, &allocated);
+    fuco_node_t *node = fuco_parser_variadic_new(parser, FUCO_NODE_BODY, 
+                                                 &allocated);
 
     while (!fuco_parser_accept(parser, FUCO_TOKEN_BRACE_CLOSE, NULL)) {
         fuco_node_t *sub = fuco_parse_body_statement(parser);
         
         if (sub == NULL) {        
             fuco_node_free(node);
+            fuco_parser_leave(parser);
 
             return NULL;
         }
 
         node = fuco_node_add_child(node, sub, &allocated);
     }
+
+    fuco_parser_leave(parser);
     
     return node;
 }
@@ -289,9 +388,7 @@ fuco_node_t *fuco_parse_body_statement(fuco_parser_t *parser) {
             break;
 
         default:
-            fuco_syntax_error(&parser->tstream->source, 
-                              "expected statement, but got %s", 
-                              fuco_token_static_string(parser->tstream));
+            fuco_parser_unexpected(parser, "statement");
 
             node = NULL;
             break;
@@ -301,7 +398,7 @@ fuco_node_t *fuco_parse_body_statement(fuco_parser_t *parser) {
 }
 
 fuco_node_t *fuco_parse_return(fuco_parser_t *parser) {
-    fuco_node_t *node = fuco_node_new(FUCO_NODE_RETURN);
+    fuco_node_t *node = fuco_parser_node_new(parser, FUCO_NODE_RETURN);
     fuco_node_t *value;
     
     if (!fuco_parser_expect(parser, FUCO_TOKEN_RETURN, node)
@@ -321,7 +418,7 @@ fuco_node_t *fuco_parse_return(fuco_parser_t *parser) {
 }
 
 fuco_node_t *fuco_parse_if_else(fuco_parser_t *parser) {
-    fuco_node_t *node = fuco_node_new(FUCO_NODE_IF_ELSE);
+    fuco_node_t *node = fuco_parser_node_new(parser, FUCO_NODE_IF_ELSE);
     fuco_node_t *cond = NULL, *true_body = NULL, *false_body = NULL;
     
     bool success = fuco_parser_expect(parser, FUCO_TOKEN_IF, node)
@@ -338,7 +435,7 @@ fuco_node_t *fuco_parse_if_else(fuco_parser_t *parser) {
 
     if (!success) {
         fuco_node_free(node);
-        fuco_node_free(node);
+        fuco_node_free(cond);
         fuco_node_free(true_body);
 
         return NULL;
@@ -352,15 +449,15 @@ fuco_node_t *fuco_parse_if_else(fuco_parser_t *parser) {
 }
 
 fuco_node_t *fuco_parse_while(fuco_parser_t *parser) {
-    fuco_node_t *node = fuco_node_new(FUCO_NODE_WHILE);
+    fuco_node_t *node = fuco_parser_node_new(parser, FUCO_NODE_WHILE);
     fuco_node_t *cond = NULL, *body = NULL;
 
     if (!fuco_parser_expect(parser, FUCO_TOKEN_WHILE, node)
         || (cond = fuco_parse_expression(parser)) == NULL
         || (body = fuco_parse_braced_block(parser)) == NULL) {
         fuco_node_free(node);
-        fuco_node_free(node);
-        fuco_node_free(node);
+        fuco_node_free(cond);
+        fuco_node_free(body);
 
         return NULL;
     }
@@ -372,60 +469,44 @@ fuco_node_t *fuco_parse_while(fuco_parser_t *parser) {
 }
 
 fuco_node_t *fuco_parse_expression(fuco_parser_t *parser) {
-    return fuco_parse_operator(parser, 0);
-}
-
-fuco_node_t *fuco_parse_operator(fuco_parser_t *parser, size_t level) {
-    if (level >= FUCO_ARRAY_SIZE(fuco_operator_specs)) {
-        return fuco_parse_value(parser);
+    if (!fuco_parser_enter(parser)) {
+        return NULL;
     }
 
-    if (fuco_operator_specs[level].associativity == FUCO_ASSOCIATIVE_LEFT) {
-        return fuco_parse_operator_left(parser, level);
-    }
+    fuco_node_t *node = fuco_parse_operator(parser, 1);
 
-    return fuco_parse_operator_right(parser, level);
+    fuco_parser_leave(parser);
+
+    return node;
 }
 
-fuco_node_t *fuco_parse_operator_left(fuco_parser_t *parser, size_t level) {
+fuco_node_t *fuco_parse_operator(fuco_parser_t *parser, uint8_t min_binding) {
     fuco_node_t *left, *right;
 
-    if ((left = fuco_parse_operator(parser, level + 1)) == NULL) {
+    if ((left = fuco_parse_value(parser)) == NULL) {
         return NULL;
     }
 
-    fuco_operator_specification_t *spec = &fuco_operator_specs[level];
-    
     while (true) {
-        fuco_token_t *operator = NULL;
+        fuco_operator_binding_t *binding 
+            = &fuco_operator_bindings[parser->tstream->type];
 
-        for (size_t i = 0; i < FUCO_MAX_OPERATORS_PER_LEVEL; i++) {
-            if (fuco_parser_check(parser, spec->operators[i])) {
-                operator = fuco_parser_advance(parser);
-                break;
-            }
-        }
-
-        if (operator != NULL) {
-            if ((right = fuco_parse_operator(parser, level + 1)) == NULL) {
-                fuco_node_free(left);
-                return NULL;
-            }
-            
-            left = fuco_node_call_new(2, left, right);
-            left->token = operator;
-        } else {
+        if (binding->left < min_binding) {
             return left;
         }
-    }
-}
 
-fuco_node_t *fuco_parse_operator_right(fuco_parser_t *parser, size_t level) {
-    FUCO_UNUSED(level);
+        fuco_token_t *operator = fuco_parser_pin(parser);
+        fuco_parser_advance(parser);
 
-    FUCO_NOT_IMPLEMENTED();
+        if ((right = fuco_parse_operator(parser, binding->right)) == NULL) {
+            fuco_node_free(left);
+            return NULL;
+        }
 
-    return fuco_parse_value(parser);
+        left = fuco_node_call_new(2, left, right);
+        parser->n_nodes += 2; /* The call and its argument list */
+        left->token = operator;
+    }
 }
 
 fuco_node_t *fuco_parse_value(fuco_parser_t *parser) {
@@ -433,13 +514,13 @@ fuco_node_t *fuco_parse_value(fuco_parser_t *parser) {
 
     switch (parser->tstream->type) {
         case FUCO_TOKEN_INTEGER:
-            node = fuco_node_new(FUCO_NODE_INTEGER);
+            node = fuco_parser_node_new(parser, FUCO_NODE_INTEGER);
             fuco_parser_move(parser, node);
             fuco_parser_advance(parser);
             break;
 
         case FUCO_TOKEN_IDENTIFIER:
-            node = fuco_node_new(FUCO_NODE_VARIABLE);
+            node = fuco_parser_node_new(parser, FUCO_NODE_VARIABLE);
             fuco_parser_move(parser, node);
             fuco_parser_advance(parser);
 
@@ -460,7 +541,7 @@ fuco_node_t *fuco_parse_value(fuco_parser_t *parser) {
         case FUCO_TOKEN_PERCENT:
             fuco_parser_advance(parser);
 
-            node = fuco_node_new(FUCO_NODE_INSTR);
+            node = fuco_parser_node_new(parser, FUCO_NODE_INSTR);
 
             if (fuco_parser_lookup_instr(parser, node)) {
                 fuco_node_free(node);
@@ -494,9 +575,7 @@ fuco_node_t *fuco_parse_value(fuco_parser_t *parser) {
             break;
 
         default:
-            fuco_syntax_error(&parser->tstream->source, 
-                              "expected value, but got %s", 
-                              fuco_tokentype_string(parser->tstream->type));
+            fuco_parser_unexpected(parser, "value");
             break;
     }
 
@@ -505,7 +584,8 @@ fuco_node_t *fuco_parse_value(fuco_parser_t *parser) {
 
 fuco_node_t *fuco_parse_args(fuco_parser_t *parser) {
     size_t allocated;
-    fuco_node_t *node = fuco_node_variadic_new(FUCO_NODE_ARG_LIST, &allocated);
+    fuco_node_t *node = fuco_parser_variadic_new(parser, FUCO_NODE_ARG_LIST, 
+                                                 &allocated);
     fuco_node_t *arg;
 
     if (!fuco_parser_expect(parser, FUCO_TOKEN_BRACKET_OPEN, NULL)) {
@@ -537,7 +617,7 @@ fuco_node_t *fuco_parse_args(fuco_parser_t *parser) {
 }
 
 fuco_node_t *fuco_parse_type(fuco_parser_t *parser) {
-    fuco_node_t *node = fuco_node_new(FUCO_NODE_TYPE_IDENTIFIER);
+    fuco_node_t *node = fuco_parser_node_new(parser, FUCO_NODE_TYPE_IDENTIFIER);
 
     if (!fuco_parser_expect(parser, FUCO_TOKEN_IDENTIFIER, node)) {
         fuco_node_free(node);
@@ -0,0 +1,107 @@
+#define _DEFAULT_SOURCE /* syscall */
+
+#include "perf.h"
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+char const *fuco_perf_event_string(fuco_perf_event_t event) {
+    switch (event) {
+        case FUCO_PERF_CYCLES:
+            return "cycles";
+        case FUCO_PERF_INSTRUCTIONS:
+            return "instructions";
+        case FUCO_PERF_BRANCH_MISSES:
+            return "branch_misses";
+        case FUCO_PERF_L1D_MISSES:
+            return "l1d_misses";
+        case FUCO_PERF_L1I_MISSES:
+            return "l1i_misses";
+        case FUCO_N_PERF_EVENTS:
+            break;
+    }
+
+    return "unknown";
+}
+
+#ifdef __linux__
+
+#define FUCO_PERF_CACHE_MISS(cache) \
+        ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) \
+         | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static struct {
+    uint32_t type;
+    uint64_t config;
+} const fuco_perf_configs[FUCO_N_PERF_EVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, FUCO_PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_L1D) },
+    { PERF_TYPE_HW_CACHE, FUCO_PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_L1I) }
+};
+
+size_t fuco_perf_open(fuco_perf_t *perf) {
+    size_t n = 0;
+
+    for (size_t i = 0; i < FUCO_N_PERF_EVENTS; i++) {
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = fuco_perf_configs[i].type;
+        attr.config = fuco_perf_configs[i].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        /* Phases run on pool workers, which are created later */
+        attr.inherit = 1;
+
+        /* This thread and its future threads on any processor */
+        perf->fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (perf->fds[i] != -1) {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+#else
+
+size_t fuco_perf_open(fuco_perf_t *perf) {
+    for (size_t i = 0; i < FUCO_N_PERF_EVENTS; i++) {
+        perf->fds[i] = -1;
+    }
+
+    return 0;
+}
+
+#endif
+
+void fuco_perf_close(fuco_perf_t *perf) {
+    for (size_t i = 0; i < FUCO_N_PERF_EVENTS; i++) {
+        if (perf->fds[i] != -1) {
+            close(perf->fds[i]);
+            perf->fds[i] = -1;
+        }
+    }
+}
+
+bool fuco_perf_available(fuco_perf_t *perf, fuco_perf_event_t event) {
+    return perf->fds[event] != -1;
+}
+
+void fuco_perf_read(fuco_perf_t *perf, uint64_t counts[FUCO_N_PERF_EVENTS]) {
+    for (size_t i = 0; i < FUCO_N_PERF_EVENTS; i++) {
+        counts[i] = 0;
+
+        if (perf->fds[i] != -1 
+            && read(perf->fds[i], &counts[i], sizeof(uint64_t)) 
+               != (ssize_t)sizeof(uint64_t)) {
+            counts[i] = 0;
+        }
+    }
+}
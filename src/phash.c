@@ -0,0 +1,88 @@
+#include "phash.h"
+#include "parser.h"
+#include "utils.h"
+#include <string.h>
+
+/* Built without tables to bootstrap the generator: falls back to linear 
+   lookups */
+#ifndef FUCO_PHASH_BOOTSTRAP
+#include "phash_tables.h"
+#endif
+
+uint32_t fuco_phash(uint32_t seed, char const *str, size_t len) {
+    uint32_t hash = 2166136261U ^ seed;
+
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)str[i]) * 16777619U;
+    }
+
+    return hash ^ (hash >> 15);
+}
+
+fuco_phash_entry_t const *fuco_phash_lookup(fuco_phash_table_t const *table, 
+                                            char const *str, size_t len) {
+    uint32_t idx = fuco_phash(table->seed, str, len) % table->size;
+    fuco_phash_entry_t const *entry = &table->entries[idx];
+
+    if (strncmp(entry->key, str, len) == 0 && entry->key[len] == '\0') {
+        return entry;
+    }
+
+    return NULL;
+}
+
+#ifndef FUCO_PHASH_BOOTSTRAP
+
+fuco_tokentype_t fuco_phash_tokentype(char const *str, size_t len, 
+                                      fuco_tokenkind_t kind) {
+    fuco_phash_table_t const *table;
+    
+    switch (kind) {
+        case FUCO_TOKENKIND_KEYWORD:
+            table = &fuco_phash_keywords;
+            break;
+
+        case FUCO_TOKENKIND_SEPARATOR:
+            table = &fuco_phash_separators;
+            break;
+
+        case FUCO_TOKENKIND_OPERATOR:
+            table = &fuco_phash_operators;
+            break;
+
+        default:
+            FUCO_UNREACHED();
+    }
+
+    fuco_phash_entry_t const *entry = fuco_phash_lookup(table, str, len);
+
+    return entry == NULL ? FUCO_TOKEN_EMPTY : entry->value;
+}
+
+fuco_opcode_t fuco_phash_instr(char const *str, size_t len) {
+    fuco_phash_entry_t const *entry = fuco_phash_lookup(&fuco_phash_instrs, 
+                                                        str, len);
+
+    return entry == NULL ? FUCO_OPCODES_N : entry->value;
+}
+
+#else
+
+fuco_tokentype_t fuco_phash_tokentype(char const *str, size_t len, 
+                                      fuco_tokenkind_t kind) {
+    return fuco_tokentype_lookup_slice(str, len, kind);
+}
+
+fuco_opcode_t fuco_phash_instr(char const *str, size_t len) {
+    for (size_t i = 0; i < FUCO_INSTR_OPCODES_N; i++) {
+        char *mnemonic = fuco_opcode_get_mnemonic(fuco_instr_opcodes[i]);
+
+        if (strncmp(mnemonic, str, len) == 0 && mnemonic[len] == '\0') {
+            return fuco_instr_opcodes[i];
+        }
+    }
+
+    return FUCO_OPCODES_N;
+}
+
+#endif
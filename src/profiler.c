@@ -0,0 +1,172 @@
+#include "profiler.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+volatile sig_atomic_t fuco_profiler_pending = 0;
+
+void fuco_profiler_init(fuco_profiler_t *profiler) {
+    profiler->cap = FUCO_PROFILER_INIT_SIZE;
+    profiler->data = malloc(profiler->cap * sizeof(uint64_t));
+    profiler->size = 0;
+    profiler->n_samples = 0;
+}
+
+void fuco_profiler_destruct(fuco_profiler_t *profiler) {
+    free(profiler->data);
+}
+
+void fuco_profiler_handle(int signal) {
+    FUCO_UNUSED(signal);
+
+    fuco_profiler_pending = 1;
+}
+
+int fuco_profiler_start(fuco_profiler_t *profiler) {
+    struct sigaction action;
+    struct itimerval timer;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = fuco_profiler_handle;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = FUCO_PROFILER_INTERVAL_US;
+    timer.it_value = timer.it_interval;
+
+    fuco_profiler_pending = 0;
+
+    if (sigaction(SIGPROF, &action, &profiler->old_action) != 0) {
+        perror("sigaction");
+        return 1;
+    }
+
+    if (setitimer(ITIMER_PROF, &timer, &profiler->old_timer) != 0) {
+        perror("setitimer");
+        sigaction(SIGPROF, &profiler->old_action, NULL);
+        return 1;
+    }
+
+    return 0;
+}
+
+void fuco_profiler_stop(fuco_profiler_t *profiler) {
+    setitimer(ITIMER_PROF, &profiler->old_timer, NULL);
+    sigaction(SIGPROF, &profiler->old_action, NULL);
+
+    fuco_profiler_pending = 0;
+}
+
+void fuco_profiler_sample(fuco_profiler_t *profiler, uint64_t ip,
+                          uint64_t bp, char const *stack) {
+    if (profiler->size + FUCO_PROFILER_MAX_DEPTH + 1 > profiler->cap) {
+        profiler->cap = 2 * profiler->cap + FUCO_PROFILER_MAX_DEPTH + 1;
+        profiler->data = realloc(profiler->data,
+                                 profiler->cap * sizeof(uint64_t));
+    }
+
+    uint64_t *sample = &profiler->data[profiler->size];
+    size_t depth = 0;
+
+    sample[++depth] = ip;
+
+    /* CALL pushes the return address and the caller's bp, startup runs
+       with bp 0 */
+    while (bp != 0 && depth < FUCO_PROFILER_MAX_DEPTH) {
+        uint64_t ret = *(uint64_t *)(stack + bp - 2 * sizeof(uint64_t));
+        bp = *(uint64_t *)(stack + bp - sizeof(uint64_t));
+
+        sample[++depth] = ret;
+    }
+
+    sample[0] = bp == 0 ? depth : depth | FUCO_PROFILER_TRUNCATED;
+
+    profiler->size += depth + 1;
+    profiler->n_samples++;
+}
+
+int fuco_profiler_compare(void const *left, void const *right) {
+    return strcmp(*(char * const *)left, *(char * const *)right);
+}
+
+/* Frames are written as names followed by their location, which keeps
+   overloads apart */
+char *fuco_profiler_fold(uint64_t *sample, fuco_ir_t *ir) {
+    char *line = NULL;
+    size_t len = 0;
+    FILE *file = open_memstream(&line, &len);
+    size_t depth = sample[0] & ~FUCO_PROFILER_TRUNCATED;
+
+    if (file == NULL) {
+        return NULL;
+    }
+
+    if (sample[0] & FUCO_PROFILER_TRUNCATED) {
+        fprintf(file, "[truncated]");
+    }
+
+    for (size_t i = depth; i > 0; i--) {
+        fuco_ir_object_t *object = fuco_ir_object_at(ir, sample[i]);
+
+        if (i != depth || sample[0] & FUCO_PROFILER_TRUNCATED) {
+            fprintf(file, ";");
+        }
+
+        if (object == NULL) {
+            fprintf(file, "[%lu]", sample[i]);
+        } else {
+            fuco_ir_object_write_name(object, file);
+        }
+    }
+
+    fclose(file);
+
+    return line;
+}
+
+int fuco_profiler_write_folded(fuco_profiler_t *profiler, fuco_ir_t *ir,
+                               FILE *file) {
+    char **lines = malloc(profiler->n_samples * sizeof(char *));
+    size_t offset = 0;
+    int error = 0;
+
+    for (size_t i = 0; i < profiler->n_samples; i++) {
+        uint64_t *sample = &profiler->data[offset];
+
+        if ((lines[i] = fuco_profiler_fold(sample, ir)) == NULL) {
+            error = 1;
+        }
+
+        offset += (sample[0] & ~FUCO_PROFILER_TRUNCATED) + 1;
+    }
+
+    if (error) {
+        for (size_t i = 0; i < profiler->n_samples; i++) {
+            free(lines[i]);
+        }
+        free(lines);
+
+        return 1;
+    }
+
+    qsort(lines, profiler->n_samples, sizeof(char *), fuco_profiler_compare);
+
+    for (size_t i = 0; i < profiler->n_samples; ) {
+        size_t j = i + 1;
+
+        while (j < profiler->n_samples && strcmp(lines[i], lines[j]) == 0) {
+            j++;
+        }
+
+        fprintf(file, "%s %zu\n", lines[i], j - i);
+
+        for (; i < j; i++) {
+            free(lines[i]);
+        }
+    }
+
+    free(lines);
+
+    return 0;
+}
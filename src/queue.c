@@ -14,9 +14,9 @@ void fuco_queue_destruct(fuco_queue_t *queue) {
 }
 
 void fuco_queue_enqueue(fuco_queue_t *queue, void *data) {
-    if (queue->size > queue->cap) {
+    if (queue->size >= queue->cap) {
         queue->cap *= 2;
-        queue->data = realloc(queue->data, queue->cap);
+        queue->data = realloc(queue->data, queue->cap * sizeof(void *));
     }
 
     queue->data[queue->size] = data;
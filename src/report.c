@@ -0,0 +1,254 @@
+#include "report.h"
+#include <time.h>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+char const *fuco_phase_string(fuco_phase_t phase) {
+    switch (phase) {
+        case FUCO_PHASE_PARSE:
+            return "parse";
+        case FUCO_PHASE_DECLARE:
+            return "declare";
+        case FUCO_PHASE_GENERATE:
+            return "generate";
+        case FUCO_PHASE_ASSEMBLE:
+            return "assemble";
+        case FUCO_PHASE_EXECUTE:
+            return "execute";
+        case FUCO_N_PHASES:
+            break;
+    }
+
+    return "unknown";
+}
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+
+#define FUCO_COUNTS_ALLOCATIONS
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+/* Replace the allocator entry points of glibc, which also routes its own 
+   allocations through them. Counting is off until a report begins, so 
+   other runs only pay for the branch */
+void *malloc(size_t size) {
+    if (fuco_allocations_counted) {
+        __atomic_fetch_add(&fuco_allocated, size, __ATOMIC_RELAXED);
+    }
+
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    if (fuco_allocations_counted) {
+        __atomic_fetch_add(&fuco_allocated, n * size, __ATOMIC_RELAXED);
+    }
+
+    return __libc_calloc(n, size);
+}
+
+/* The full new size is counted, as for a new allocation */
+void *realloc(void *ptr, size_t size) {
+    if (fuco_allocations_counted) {
+        __atomic_fetch_add(&fuco_allocated, size, __ATOMIC_RELAXED);
+    }
+
+    return __libc_realloc(ptr, size);
+}
+
+#endif
+
+bool fuco_allocations_counted = false;
+
+uint64_t fuco_allocated = 0;
+
+uint64_t fuco_allocated_bytes(void) {
+    return __atomic_load_n(&fuco_allocated, __ATOMIC_RELAXED);
+}
+
+double fuco_clock_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+size_t fuco_heap_in_use(void) {
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    struct mallinfo2 info = mallinfo2();
+
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+size_t fuco_peak_rss(void) {
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+
+    return (size_t)usage.ru_maxrss * 1024; /* Kilobytes on Linux */
+}
+
+void fuco_report_init(fuco_report_t *report) {
+    for (size_t i = 0; i < FUCO_N_PHASES; i++) {
+        report->phases[i].seconds = 0.0;
+        report->phases[i].allocated = 0;
+        report->phases[i].heap_delta = 0;
+        for (size_t j = 0; j < FUCO_N_PERF_EVENTS; j++) {
+            report->phases[i].counts[j] = 0;
+        }
+    }
+
+    report->start = 0.0;
+    report->start_heap = 0;
+    report->start_allocated = 0;
+    report->n_tokens = report->n_nodes = report->n_symbols = 0;
+    report->n_ir_units = report->n_bytecode_words = 0;
+    report->heap = report->peak_rss = 0;
+    report->perf = NULL;
+}
+
+void fuco_report_begin(fuco_report_t *report) {
+    if (report == NULL) {
+        return;
+    }
+
+#ifdef FUCO_COUNTS_ALLOCATIONS
+    fuco_allocations_counted = true;
+#endif
+
+    report->start_heap = fuco_heap_in_use();
+    report->start_allocated = fuco_allocated_bytes();
+    report->start = fuco_clock_now();
+
+    /* Read last and first in end, keeping the bookkeeping out */
+    if (report->perf != NULL) {
+        fuco_perf_read(report->perf, report->start_counts);
+    }
+}
+
+void fuco_report_end(fuco_report_t *report, fuco_phase_t phase) {
+    if (report == NULL) {
+        return;
+    }
+
+    uint64_t counts[FUCO_N_PERF_EVENTS];
+
+    if (report->perf != NULL) {
+        fuco_perf_read(report->perf, counts);
+
+        for (size_t i = 0; i < FUCO_N_PERF_EVENTS; i++) {
+            report->phases[phase].counts[i] += 
+                    counts[i] - report->start_counts[i];
+        }
+    }
+
+    double end = fuco_clock_now();
+
+    report->heap = fuco_heap_in_use();
+    report->phases[phase].seconds += end - report->start;
+    report->phases[phase].allocated += 
+            fuco_allocated_bytes() - report->start_allocated;
+    report->phases[phase].heap_delta +=
+            (int64_t)report->heap - (int64_t)report->start_heap;
+    report->peak_rss = fuco_peak_rss();
+}
+
+/* Unavailable events are written as '-' */
+void fuco_report_write_counters(fuco_report_t *report, FILE *file) {
+    fprintf(file, "\n%-12s", "phase");
+    for (size_t i = 0; i < FUCO_N_PERF_EVENTS; i++) {
+        fprintf(file, " %14s", fuco_perf_event_string(i));
+    }
+    fprintf(file, " %6s\n", "IPC");
+
+    for (size_t i = 0; i < FUCO_N_PHASES; i++) {
+        uint64_t *counts = report->phases[i].counts;
+
+        fprintf(file, "%-12s", fuco_phase_string(i));
+
+        for (size_t j = 0; j < FUCO_N_PERF_EVENTS; j++) {
+            if (fuco_perf_available(report->perf, j)) {
+                fprintf(file, " %14lu", counts[j]);
+            } else {
+                fprintf(file, " %14s", "-");
+            }
+        }
+
+        if (counts[FUCO_PERF_CYCLES] > 0) {
+            fprintf(file, " %6.2f\n", (double)counts[FUCO_PERF_INSTRUCTIONS]
+                                      / counts[FUCO_PERF_CYCLES]);
+        } else {
+            fprintf(file, " %6s\n", "-");
+        }
+    }
+}
+
+void fuco_report_write(fuco_report_t *report, FILE *file) {
+    double total = 0.0;
+
+    uint64_t allocated = 0;
+
+    fprintf(file, "%-12s %12s %16s %16s\n", "phase", "time (ms)", 
+            "allocated (KiB)", "heap (KiB)");
+
+    for (size_t i = 0; i < FUCO_N_PHASES; i++) {
+        fuco_phase_report_t *phase = &report->phases[i];
+
+        fprintf(file, "%-12s %12.3f %16.1f %+16.1f\n", fuco_phase_string(i),
+                phase->seconds * 1e3, phase->allocated / 1024.0, 
+                phase->heap_delta / 1024.0);
+        total += phase->seconds;
+        allocated += phase->allocated;
+    }
+
+    fprintf(file, "%-12s %12.3f %16.1f %16.1f\n", "total", total * 1e3,
+            allocated / 1024.0, report->heap / 1024.0);
+
+    fprintf(file, "tokens %zu, nodes %zu, symbols %zu, IR units %zu, "
+            "bytecode words %zu\n", report->n_tokens, report->n_nodes,
+            report->n_symbols, report->n_ir_units, report->n_bytecode_words);
+    fprintf(file, "peak RSS %.1f MiB\n", report->peak_rss / 1048576.0);
+
+    if (report->perf != NULL) {
+        fuco_report_write_counters(report, file);
+    }
+}
+
+void fuco_report_write_json(fuco_report_t *report, FILE *file) {
+    fprintf(file, "{\"phases\": [");
+
+    for (size_t i = 0; i < FUCO_N_PHASES; i++) {
+        fuco_phase_report_t *phase = &report->phases[i];
+
+        fprintf(file, "%s{\"name\": \"%s\", \"seconds\": %.9f, "
+                "\"allocated\": %lu, \"heap_delta\": %lld", 
+                i == 0 ? "" : ", ", fuco_phase_string(i), phase->seconds,
+                phase->allocated, (long long)phase->heap_delta);
+
+        /* Only available events are included */
+        for (size_t j = 0; report->perf != NULL && j < FUCO_N_PERF_EVENTS; 
+             j++) {
+            if (fuco_perf_available(report->perf, j)) {
+                fprintf(file, ", \"%s\": %lu", fuco_perf_event_string(j),
+                        phase->counts[j]);
+            }
+        }
+
+        fprintf(file, "}");
+    }
+
+    fprintf(file, "], \"tokens\": %zu, \"nodes\": %zu, \"symbols\": %zu, "
+            "\"ir_units\": %zu, \"bytecode_words\": %zu, \"heap\": %zu, "
+            "\"peak_rss\": %zu}\n", report->n_tokens, report->n_nodes,
+            report->n_symbols, report->n_ir_units, report->n_bytecode_words,
+            report->heap, report->peak_rss);
+}
@@ -69,3 +69,81 @@ char *fuco_strdup(char *str) {
 void fuco_string_write(void *string, FILE *file) {
     fputs(string, file);
 }
+
+fuco_hashvalue_t fuco_slice_hash(char const *str, size_t len) {
+    fuco_hashvalue_t hash = 5381;
+
+    for (size_t i = 0; i < len; i++) {
+        hash = ((hash << 5) + hash) + str[i];
+    }
+
+    return hash;
+}
+
+void fuco_strtable_init(fuco_strtable_t *table) {
+    table->cap = FUCO_STRTABLE_INIT_SIZE;
+    table->strs = calloc(table->cap, sizeof(char *));
+    table->size = 0;
+}
+
+void fuco_strtable_destruct(fuco_strtable_t *table) {
+    for (size_t i = 0; i < table->cap; i++) {
+        if (table->strs[i] != NULL) {
+            free(table->strs[i]);
+        }
+    }
+
+    free(table->strs);
+}
+
+void fuco_strtable_rehash(fuco_strtable_t *table) {
+    size_t cap = 2 * table->cap;
+    char **strs = calloc(cap, sizeof(char *));
+
+    for (size_t i = 0; i < table->cap; i++) {
+        char *str = table->strs[i];
+
+        if (str == NULL) {
+            continue;
+        }
+
+        size_t idx = fuco_slice_hash(str, strlen(str)) & (cap - 1);
+
+        while (strs[idx] != NULL) {
+            idx = (idx + 1) & (cap - 1);
+        }
+
+        strs[idx] = str;
+    }
+
+    free(table->strs);
+    table->strs = strs;
+    table->cap = cap;
+}
+
+char *fuco_strtable_intern(fuco_strtable_t *table, char const *str, 
+                           size_t len) {
+    if (2 * (table->size + 1) > table->cap) {
+        fuco_strtable_rehash(table);
+    }
+
+    size_t idx = fuco_slice_hash(str, len) & (table->cap - 1);
+    char *entry;
+
+    while ((entry = table->strs[idx]) != NULL) {
+        if (strncmp(entry, str, len) == 0 && entry[len] == '\0') {
+            return entry;
+        }
+
+        idx = (idx + 1) & (table->cap - 1);
+    }
+
+    entry = malloc(len + 1);
+    memcpy(entry, str, len);
+    entry[len] = '\0';
+
+    table->strs[idx] = entry;
+    table->size++;
+
+    return entry;
+}
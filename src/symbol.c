@@ -77,32 +77,6 @@ fuco_symbol_t *fuco_scope_lookup_token(fuco_scope_t *scope,
                              &token->source, true);
 }
 
-fuco_symbol_t *fuco_scope_lookup_conversion(fuco_scope_t *scope, 
-                                            fuco_node_t *from, 
-                                            fuco_node_t *to) {
-    char *str = fuco_tokentype_string(FUCO_TOKEN_CONVERT);
-    
-    /* FUTURE: Like call resolution, also search outer scopes (traverse) */
-    fuco_symbol_t *conv = fuco_scope_lookup(scope, str, NULL, false);
-    
-    while (conv != NULL) {
-        fuco_node_t *def = conv->def;
-        fuco_node_t *params = def->children[FUCO_LAYOUT_FUNCTION_PARAMS];
-
-        fuco_node_t *from_type = params->children[0]->data.datatype;
-        fuco_node_t *to_type = def->children[FUCO_LAYOUT_FUNCTION_RET_TYPE];
-
-        if (fuco_node_type_equal(from_type, from) 
-            && fuco_node_type_equal(to_type, to)) {
-            return conv;
-        }
-
-        conv = conv->link;
-    }
-
-    return NULL;
-}
-
 fuco_symbol_t *fuco_scope_insert(fuco_scope_t *scope, 
                                  fuco_token_t *token, fuco_symbol_t *symbol) {        
     void **value = fuco_map_insert(&scope->names, 
@@ -134,30 +108,184 @@ fuco_symbol_t *fuco_scope_insert(fuco_scope_t *scope,
     return symbol;
 }
 
+fuco_typeid_t fuco_conversion_get_from(fuco_symbol_t *conv) {
+    fuco_node_t *params = conv->def->children[FUCO_LAYOUT_FUNCTION_PARAMS];
+
+    return params->children[0]->data.datatype->data.typeid;
+}
+
+fuco_typeid_t fuco_conversion_get_to(fuco_symbol_t *conv) {
+    return conv->def->children[FUCO_LAYOUT_FUNCTION_RET_TYPE]->data.typeid;
+}
+
+void fuco_conversion_table_init(fuco_conversion_table_t *convs) {
+    convs->types = NULL;
+    convs->direct = NULL;
+    convs->first = NULL;
+    convs->size = 0;
+}
+
+void fuco_conversion_table_destruct(fuco_conversion_table_t *convs) {
+    free(convs->direct);
+    free(convs->first);
+}
+
+bool fuco_conversion_table_index(fuco_conversion_table_t *convs, 
+                                 fuco_typeid_t id, size_t *index) {
+    if (convs->types == NULL || id == FUCO_TYPEID_INVALID 
+        || id >= convs->types->size) {
+        return false;
+    }
+
+    fuco_type_t *type = fuco_typetable_get(convs->types, id);
+
+    if (type->kind != FUCO_TYPEKIND_NAMED || type->index >= convs->size) {
+        return false;
+    }
+
+    *index = type->index;
+
+    return true;
+}
+
+void fuco_conversion_table_setup(fuco_conversion_table_t *convs, 
+                                 fuco_symboltable_t *table, 
+                                 fuco_scope_t *scope) {
+    size_t size = table->types.counts[FUCO_TYPEKIND_NAMED];
+
+    fuco_conversion_table_destruct(convs);
+
+    convs->types = &table->types;
+    convs->size = size;
+    convs->direct = calloc(size * size, sizeof(fuco_symbol_t *));
+    convs->first = calloc(size * size, sizeof(fuco_symbol_t *));
+
+    char *str = fuco_tokentype_string(FUCO_TOKEN_CONVERT);
+    fuco_symbol_t *conv = fuco_scope_lookup(scope, str, NULL, false);
+
+    /* Most recent overloads come first and take precedence */
+    while (conv != NULL) {
+        fuco_node_t *params = conv->def->children[FUCO_LAYOUT_FUNCTION_PARAMS];
+
+        size_t from, to;
+
+        if (params->count == 1
+            && fuco_conversion_table_index(convs, 
+                                           fuco_conversion_get_from(conv), 
+                                           &from)
+            && fuco_conversion_table_index(convs, 
+                                           fuco_conversion_get_to(conv), 
+                                           &to)) {
+            if (convs->direct[from * size + to] == NULL) {
+                convs->direct[from * size + to] = conv;
+            }
+        }
+
+        conv = conv->link;
+    }
+
+    /* Breadth-first search from every type yields the first conversion of a 
+       shortest chain to every reachable type */
+    size_t *queue = malloc(size * sizeof(size_t));
+
+    for (size_t src = 0; src < size; src++) {
+        fuco_symbol_t **first = &convs->first[src * size];
+        size_t head = 0, tail = 0;
+
+        queue[tail++] = src;
+
+        while (head < tail) {
+            size_t curr = queue[head++];
+            fuco_symbol_t **direct = &convs->direct[curr * size];
+
+            for (size_t dst = 0; dst < size; dst++) {
+                if (direct[dst] == NULL || dst == src || first[dst] != NULL) {
+                    continue;
+                }
+
+                first[dst] = curr == src ? direct[dst] : first[curr];
+                queue[tail++] = dst;
+            }
+        }
+    }
+
+    free(queue);
+}
+
+fuco_symbol_t *fuco_conversion_table_lookup(fuco_conversion_table_t *convs, 
+                                            fuco_typeid_t from, 
+                                            fuco_typeid_t to) {
+    size_t src, dst;
+
+    if (!fuco_conversion_table_index(convs, from, &src)
+        || !fuco_conversion_table_index(convs, to, &dst)) {
+        return NULL;
+    }
+
+    return convs->direct[src * convs->size + dst];
+}
+
+size_t fuco_conversion_table_chain(fuco_conversion_table_t *convs, 
+                                   fuco_typeid_t from, fuco_typeid_t to, 
+                                   fuco_symbol_t **chain, size_t max) {
+    size_t src, dst;
+
+    if (!fuco_conversion_table_index(convs, from, &src)
+        || !fuco_conversion_table_index(convs, to, &dst)) {
+        return 0;
+    }
+
+    size_t len = 0;
+    
+    while (src != dst) {
+        fuco_symbol_t *conv = convs->first[src * convs->size + dst];
+
+        if (conv == NULL) {
+            return 0;
+        }
+
+        if (len < max) {
+            chain[len] = conv;
+        }
+
+        len++;
+        fuco_conversion_table_index(convs, fuco_conversion_get_to(conv), 
+                                    &src);
+    }
+
+    return len;
+}
+
 fuco_symbol_chunk_t *fuco_symbol_chunk_new() {
     fuco_symbol_chunk_t *chunk = malloc(sizeof(fuco_symbol_chunk_t));
     
     chunk->size = 0;
-    chunk->next = NULL;
 
     return chunk;
 }
 
 void fuco_symboltable_init(fuco_symboltable_t *table) {
-    table->front = table->back = fuco_symbol_chunk_new();
+    table->cap_chunks = FUCO_SYMBOL_DIRECTORY_INIT_SIZE;
+    table->chunks = malloc(table->cap_chunks * sizeof(fuco_symbol_chunk_t *));
+    table->chunks[0] = fuco_symbol_chunk_new();
+    table->n_chunks = 1;
     table->size = 0;
+    fuco_typetable_init(&table->types);
+    fuco_conversion_table_init(&table->conversions);
     table->synthetic.root = fuco_node_variadic_new(FUCO_NODE_BODY, 
                                                    &table->synthetic.allocated);
 }
 
 void fuco_symboltable_destruct(fuco_symboltable_t *table) {    
-    fuco_symbol_chunk_t *chunk = table->back;
-    while (chunk != NULL) {
-        fuco_symbol_chunk_t *next = chunk->next;
-        free(chunk);
-        chunk = next;
+    for (size_t i = 0; i < table->n_chunks; i++) {
+        free(table->chunks[i]);
     }
 
+    free(table->chunks);
+
+    fuco_typetable_destruct(&table->types);
+    fuco_conversion_table_destruct(&table->conversions);
+
     if (table->synthetic.root != NULL) {
         fuco_node_free(table->synthetic.root);
     }
@@ -166,38 +294,29 @@ void fuco_symboltable_destruct(fuco_symboltable_t *table) {
 void fuco_symboltable_write(fuco_symboltable_t *table, FILE *file) {
     size_t max = 0;
 
-    fuco_symbol_chunk_t *chunk = table->back;
-    while (chunk != NULL) {
-        for (size_t i = 0; i < chunk->size; i++) {
-            size_t len = strlen(fuco_token_string(chunk->data[i].token));
+    for (size_t i = 0; i < table->size; i++) {
+        fuco_symbol_t *symbol = fuco_symboltable_lookup(table, i);
+        size_t len = strlen(fuco_token_string(symbol->token));
 
-            if (len > max) {
-                max = len;
-            }
+        if (len > max) {
+            max = len;
         }
-
-        chunk = chunk->next;
     }
 
-    chunk = table->back;
-    while (chunk != NULL) {
-        for (size_t i = 0; i < chunk->size; i++) {
-            fuco_symbol_t *symbol = &chunk->data[i];
-            fprintf(file, " %*s: %*d %6s (def=%d,val=%d,obj=%ld)", 
-                    (int)max, fuco_token_string(symbol->token), 
-                    fuco_ceil_log(table->size, 10),
-                    symbol->id, fuco_symboltype_string(symbol->type),
-                    symbol->def != NULL,
-                    symbol->value != NULL, symbol->obj);
-            
-            if (symbol->link != NULL) {
-                fprintf(file, " => %d", symbol->link->id);
-            }
-
-            fprintf(file, "\n");
+    for (size_t i = 0; i < table->size; i++) {
+        fuco_symbol_t *symbol = fuco_symboltable_lookup(table, i);
+        fprintf(file, " %*s: %*d %6s (def=%d,val=%d,obj=%ld)", 
+                (int)max, fuco_token_string(symbol->token), 
+                fuco_ceil_log(table->size, 10),
+                symbol->id, fuco_symboltype_string(symbol->type),
+                symbol->def != NULL,
+                symbol->value != NULL, symbol->obj);
+        
+        if (symbol->link != NULL) {
+            fprintf(file, " => %d", symbol->link->id);
         }
 
-        chunk = chunk->next;
+        fprintf(file, "\n");
     }
 }
 
@@ -228,6 +347,8 @@ void fuco_symboltable_add_synthetic(fuco_symboltable_t *table,
     
     assert(node->symbol != NULL);
 
+    node->data.typeid = node->symbol->typeid;
+
     table->synthetic.root = fuco_node_add_child(table->synthetic.root, node, 
                                                 &table->synthetic.allocated);
 
@@ -239,10 +360,17 @@ fuco_symbol_t *fuco_symboltable_insert(fuco_symboltable_t *table,
                                        fuco_token_t *token,
                                        fuco_node_t *def,
                                        fuco_symboltype_t type) {
-    fuco_symbol_chunk_t *chunk = table->front;
+    fuco_symbol_chunk_t *chunk = table->chunks[table->n_chunks - 1];
     
     if (chunk->size >= FUCO_SYMBOL_CHUNK_SIZE) {
-        table->front = chunk = chunk->next = fuco_symbol_chunk_new();
+        if (table->n_chunks >= table->cap_chunks) {
+            table->cap_chunks *= 2;
+            table->chunks = realloc(table->chunks, table->cap_chunks 
+                                    * sizeof(fuco_symbol_chunk_t *));
+        }
+
+        chunk = table->chunks[table->n_chunks] = fuco_symbol_chunk_new();
+        table->n_chunks++;
     }
 
     fuco_symbol_t *symbol = &chunk->data[chunk->size];
@@ -251,6 +379,7 @@ fuco_symbol_t *fuco_symboltable_insert(fuco_symboltable_t *table,
     symbol->id = table->size;
     symbol->type = type;
     symbol->def = def;
+    symbol->typeid = FUCO_TYPEID_INVALID;
     symbol->value = NULL;
     symbol->obj = 0;
     symbol->link = NULL;
@@ -258,6 +387,10 @@ fuco_symbol_t *fuco_symboltable_insert(fuco_symboltable_t *table,
     table->size++;
     chunk->size++;
 
+    if (type == FUCO_SYMBOL_TYPE) {
+        symbol->typeid = fuco_typetable_named(&table->types, symbol->id);
+    }
+
     if (scope != NULL && 
         fuco_scope_insert(scope, symbol->token, symbol) == NULL) {
         return NULL;
@@ -267,18 +400,12 @@ fuco_symbol_t *fuco_symboltable_insert(fuco_symboltable_t *table,
 }
 
 fuco_symbol_t *fuco_symboltable_lookup(fuco_symboltable_t *table, 
-                                          fuco_symbolid_t id) {
-    size_t i = id;
-    fuco_symbol_chunk_t *chunk = table->back;
-
-    while (i >= chunk->size && chunk != NULL) {
-        i -= chunk->size;
-        chunk = chunk->next;
-    }
+                                       fuco_symbolid_t id) {
+    assert(id < table->size);
 
-    assert(chunk != NULL);
+    fuco_symbol_chunk_t *chunk = table->chunks[id >> FUCO_SYMBOL_CHUNK_BITS];
 
-    return &chunk->data[i];
+    return &chunk->data[id & (FUCO_SYMBOL_CHUNK_SIZE - 1)];
 }
 
 fuco_node_t *fuco_symboltable_get_type(fuco_symboltable_t *table, 
@@ -290,3 +417,10 @@ fuco_node_t *fuco_symboltable_get_type(fuco_symboltable_t *table,
 
     return symbol->def;
 }
+
+fuco_symbol_t *fuco_symboltable_lookup_conversion(fuco_symboltable_t *table, 
+                                                  fuco_node_t *from, 
+                                                  fuco_node_t *to) {
+    return fuco_conversion_table_lookup(&table->conversions, 
+                                        from->data.typeid, to->data.typeid);
+}
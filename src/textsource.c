@@ -1,22 +1,233 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "textsource.h"
+#include "utils.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+fuco_sourcefiles_t fuco_sourcefiles = {
+    .files = NULL, .size = 0, .cap = 0, .lock = PTHREAD_MUTEX_INITIALIZER
+};
+
+int fuco_sourcefile_map(fuco_sourcefile_t *file, char *filename) {
+    struct stat st;
+    int fd = open(filename, O_RDONLY);
+
+    file->filename = filename;
+    file->data = NULL;
+    file->size = 0;
+    file->lines = NULL;
+    file->n_lines = 0;
+
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        if (fd != -1) {
+            close(fd);
+        }
+
+        fuco_syntax_error(NULL, "could not open file: %s", filename);
+        return 1;
+    }
+
+    if ((uint64_t)st.st_size > UINT32_MAX) { /* Offsets are 32-bit */
+        close(fd);
+
+        fuco_syntax_error(NULL, "file too large: %s", filename);
+        return 1;
+    }
 
-void fuco_textsource_init(fuco_textsource_t *source, char *filename) {
-    source->filename = filename;
-    source->row = 1;
-    source->col = 0;
+    file->size = st.st_size;
+
+    if (file->size != 0) { /* mmap rejects empty mappings */
+        file->data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (file->data == MAP_FAILED) {
+            file->data = NULL;
+            file->size = 0;
+            close(fd);
+
+            fuco_syntax_error(NULL, "could not map file: %s", filename);
+            return 1;
+        }
+    }
+
+    close(fd);
+
+    return 0;
 }
 
-void fuco_textsource_write(fuco_textsource_t *source, FILE *file) {
-    fprintf(file, "%s:%ld:%ld", source->filename, source->row, source->col);
+void fuco_sourcefile_unmap(fuco_sourcefile_t *file) {
+    if (file->data != NULL) {
+        munmap(file->data, file->size);
+    }
+
+    free(file->lines);
+
+    file->data = NULL; /* Size is kept to tell closed from empty files */
+    file->lines = NULL;
+    file->n_lines = 0;
 }
 
-void fuco_textsource_next_char(fuco_textsource_t *source, int c) {
-    if (c == '\n') {
-        source->row++;
-        source->col = 1;
+void fuco_sourcefile_index_lines(fuco_sourcefile_t *file) {
+    size_t cap = 64;
+    char *p = file->data, *end = file->data + file->size;
+
+    assert(file->lines == NULL);
+
+    file->lines = malloc(cap * sizeof(uint32_t));
+    file->lines[0] = 0;
+    file->n_lines = 1;
+
+    while (p < end && (p = memchr(p, '\n', end - p)) != NULL) {
+        p++;
+
+        if (file->n_lines >= cap) {
+            cap *= 2;
+            file->lines = realloc(file->lines, cap * sizeof(uint32_t));
+        }
+
+        file->lines[file->n_lines] = p - file->data;
+        file->n_lines++;
+    }
+}
+
+uint32_t fuco_sourcefiles_open(char *filename) {
+    fuco_sourcefiles_t *files = &fuco_sourcefiles;
+    fuco_sourcefile_t *file = malloc(sizeof(fuco_sourcefile_t));
+
+    if (fuco_sourcefile_map(file, filename)) {
+        free(file);
+        return FUCO_SOURCEFILE_NONE;
+    }
+
+    pthread_mutex_lock(&files->lock);
+
+    if (files->files == NULL) {
+        files->cap = FUCO_SOURCEFILES_INIT_SIZE;
+        files->files = malloc(files->cap * sizeof(fuco_sourcefile_t *));
+        files->files[FUCO_SOURCEFILE_NONE] = NULL;
+        files->size = 1;
+    }
+
+    if (files->size >= files->cap) {
+        files->cap *= 2;
+        files->files = realloc(files->files, 
+                               files->cap * sizeof(fuco_sourcefile_t *));
+    }
+
+    uint32_t id = files->size;
+    files->files[id] = file;
+    files->size++;
+
+    pthread_mutex_unlock(&files->lock);
+
+    return id;
+}
+
+void fuco_sourcefiles_close(uint32_t id) {
+    fuco_sourcefile_t *file = fuco_sourcefiles_get(id);
+
+    pthread_mutex_lock(&fuco_sourcefiles.lock);
+    fuco_sourcefile_unmap(file);
+    pthread_mutex_unlock(&fuco_sourcefiles.lock);
+}
+
+void fuco_sourcefiles_destruct(void) {
+    fuco_sourcefiles_t *files = &fuco_sourcefiles;
+
+    pthread_mutex_lock(&files->lock);
+
+    for (size_t i = 1; i < files->size; i++) {
+        fuco_sourcefile_unmap(files->files[i]);
+        free(files->files[i]);
+    }
+
+    free(files->files);
+    files->files = NULL;
+    files->size = files->cap = 0;
+
+    pthread_mutex_unlock(&files->lock);
+}
+
+fuco_sourcefile_t *fuco_sourcefiles_get(uint32_t id) {
+    fuco_sourcefile_t *file;
+
+    assert(id != FUCO_SOURCEFILE_NONE);
+
+    pthread_mutex_lock(&fuco_sourcefiles.lock);
+
+    assert(id < fuco_sourcefiles.size);
+    file = fuco_sourcefiles.files[id];
+
+    pthread_mutex_unlock(&fuco_sourcefiles.lock);
+
+    return file;
+}
+
+void fuco_textsource_init(fuco_textsource_t *source, uint32_t file, 
+                          uint32_t offset) {
+    source->file = file;
+    source->offset = offset;
+}
+
+int fuco_textsource_get_position(fuco_textsource_t *source, 
+                                 size_t *row, size_t *col) {
+    if (source->file == FUCO_SOURCEFILE_NONE) {
+        return 1;
+    }
+
+    fuco_sourcefile_t *file = fuco_sourcefiles_get(source->file);
+    int closed = 0;
+
+    pthread_mutex_lock(&fuco_sourcefiles.lock);
+
+    if (file->lines == NULL) {
+        if (file->data == NULL && file->size != 0) {
+            closed = 1;
+        } else {
+            fuco_sourcefile_index_lines(file);
+        }
+    }
+
+    pthread_mutex_unlock(&fuco_sourcefiles.lock);
+
+    if (closed) {
+        return 1;
+    }
+
+    size_t lo = 0, hi = file->n_lines;
+
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (file->lines[mid] <= source->offset) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    *row = lo + 1;
+    *col = source->offset - file->lines[lo] + 1;
+
+    return 0;
+}
+
+void fuco_textsource_write(fuco_textsource_t *source, FILE *file) {
+    size_t row, col;
+
+    if (source->file == FUCO_SOURCEFILE_NONE) {
+        fprintf(file, "<builtin>");
+    } else if (fuco_textsource_get_position(source, &row, &col)) {
+        fprintf(file, "%s:+%u", fuco_sourcefiles_get(source->file)->filename, 
+                source->offset);
     } else {
-        source->col++;
+        fprintf(file, "%s:%ld:%ld", 
+                fuco_sourcefiles_get(source->file)->filename, row, col);
     }
 }
@@ -0,0 +1,147 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "threadpool.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+size_t fuco_threadpool_default_size(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n < 1 ? 1 : (size_t)n;
+}
+
+void fuco_threadpool_init(fuco_threadpool_t *pool, size_t n_threads) {
+    fuco_queue_init(&pool->jobs);
+    pool->pending = 0;
+    pool->stopping = false;
+    pool->n_threads = 0;
+    pool->threads = NULL;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->has_jobs, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    if (n_threads == 0) {
+        return;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, FUCO_THREADPOOL_STACK_SIZE);
+
+    pool->threads = malloc(n_threads * sizeof(pthread_t));
+
+    for (size_t i = 0; i < n_threads; i++) {
+        if (pthread_create(&pool->threads[i], &attr, 
+                           fuco_threadpool_worker, pool)) {
+            break;
+        }
+
+        pool->n_threads++;
+    }
+
+    pthread_attr_destroy(&attr);
+}
+
+size_t fuco_threadpool_stack_size(fuco_threadpool_t *pool) {
+    struct rlimit limit;
+
+    if (pool->n_threads > 0) {
+        return FUCO_THREADPOOL_STACK_SIZE;
+    }
+
+    if (getrlimit(RLIMIT_STACK, &limit)) {
+        return (size_t)8 << 20; /* Common default */
+    }
+
+    if (limit.rlim_cur == RLIM_INFINITY) {
+        return FUCO_THREADPOOL_STACK_SIZE;
+    }
+
+    return limit.rlim_cur;
+}
+
+void fuco_threadpool_destruct(fuco_threadpool_t *pool) {
+    fuco_threadpool_wait(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->has_jobs);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->n_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    free(pool->threads);
+    fuco_queue_destruct(&pool->jobs);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->has_jobs);
+    pthread_cond_destroy(&pool->idle);
+}
+
+void fuco_threadpool_submit(fuco_threadpool_t *pool, fuco_job_func_t func, 
+                            void *arg) {
+    if (pool->n_threads == 0) {
+        func(arg);
+        return;
+    }
+
+    fuco_job_t *job = malloc(sizeof(fuco_job_t));
+    job->func = func;
+    job->arg = arg;
+
+    pthread_mutex_lock(&pool->lock);
+
+    fuco_queue_enqueue(&pool->jobs, job);
+    pool->pending++;
+
+    pthread_cond_signal(&pool->has_jobs);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void fuco_threadpool_wait(fuco_threadpool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void *fuco_threadpool_worker(void *arg) {
+    fuco_threadpool_t *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (true) {
+        while (fuco_queue_empty(&pool->jobs) && !pool->stopping) {
+            pthread_cond_wait(&pool->has_jobs, &pool->lock);
+        }
+
+        if (fuco_queue_empty(&pool->jobs)) { /* Stopping */
+            break;
+        }
+
+        fuco_job_t *job = fuco_queue_dequeue(&pool->jobs);
+
+        pthread_mutex_unlock(&pool->lock);
+
+        job->func(job->arg);
+        free(job);
+
+        pthread_mutex_lock(&pool->lock);
+
+        pool->pending--;
+        if (pool->pending == 0) {
+            pthread_cond_broadcast(&pool->idle);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
@@ -8,7 +8,7 @@
 fuco_token_t null_token = {
     .lexeme = NULL, 
     .source = {
-        .col = 0, .row = 0, .filename = NULL
+        .file = FUCO_SOURCEFILE_NONE, .offset = 0
     }, 
     .type = FUCO_TOKEN_NULL
 };
@@ -16,7 +16,7 @@ fuco_token_t null_token = {
 fuco_token_t int_token = {
     .lexeme = "Int",
     .source = {
-        .col = 0, .row = 0, .filename = NULL
+        .file = FUCO_SOURCEFILE_NONE, .offset = 0
     },
     .type = FUCO_TOKEN_IDENTIFIER
 };
@@ -24,7 +24,7 @@ fuco_token_t int_token = {
 fuco_token_t float_token = {
     .lexeme = "Float",
     .source = {
-        .col = 0, .row = 0, .filename = NULL
+        .file = FUCO_SOURCEFILE_NONE, .offset = 0
     },
     .type = FUCO_TOKEN_IDENTIFIER
 };
@@ -32,7 +32,7 @@ fuco_token_t float_token = {
 fuco_token_t bool_token = {
     .lexeme = "Bool",
     .source = {
-        .col = 0, .row = 0, .filename = NULL
+        .file = FUCO_SOURCEFILE_NONE, .offset = 0
     },
     .type = FUCO_TOKEN_IDENTIFIER
 };
@@ -40,7 +40,7 @@ fuco_token_t bool_token = {
 fuco_token_t none_token = {
     .lexeme = "None",
     .source = {
-        .col = 0, .row = 0, .filename = NULL
+        .file = FUCO_SOURCEFILE_NONE, .offset = 0
     },
     .type = FUCO_TOKEN_IDENTIFIER
 };
@@ -52,6 +52,7 @@ fuco_tokenkind_t fuco_tokentype_kind(fuco_tokentype_t type) {
         case FUCO_TOKEN_START_OF_SOURCE:
         case FUCO_TOKEN_END_OF_FILE:
         case FUCO_TOKEN_END_OF_SOURCE:
+        case FUCO_TOKEN_ERROR:
             return FUCO_TOKENKIND_SYNTHETIC;
 
         case FUCO_TOKEN_INTEGER:
@@ -121,6 +122,9 @@ char *fuco_tokentype_string(fuco_tokentype_t type) {
         case FUCO_TOKEN_END_OF_SOURCE:
             return "(end of source)";
 
+        case FUCO_TOKEN_ERROR:
+            return "(error)";
+
         case FUCO_TOKEN_INTEGER:
             return "(integer)";
 
@@ -235,10 +239,19 @@ char *fuco_tokentype_string(fuco_tokentype_t type) {
 
 fuco_tokentype_t fuco_tokentype_lookup_string(char *lexeme, 
                                               fuco_tokenkind_t kind) {
+    return fuco_tokentype_lookup_slice(lexeme, strlen(lexeme), kind);
+}
+
+fuco_tokentype_t fuco_tokentype_lookup_slice(char const *start, size_t len, 
+                                             fuco_tokenkind_t kind) {
     for (size_t i = 0; i < FUCO_N_TOKENTYPES; i++) {
+        if (fuco_tokentype_kind(i) != kind) {
+            continue;
+        }
+
         char *str = fuco_tokentype_string(i);
 
-        if (fuco_tokentype_kind(i) == kind && strcmp(str, lexeme) == 0) {
+        if (strncmp(str, start, len) == 0 && str[len] == '\0') {
             return i;
         }
     }
@@ -249,14 +262,12 @@ fuco_tokentype_t fuco_tokentype_lookup_string(char *lexeme,
 void fuco_token_init(fuco_token_t *token) {
     token->lexeme = NULL;
     token->data = NULL;
-    fuco_textsource_init(&token->source, NULL);
+    fuco_textsource_init(&token->source, FUCO_SOURCEFILE_NONE, 0);
+    token->length = 0;
     token->type = FUCO_TOKEN_EMPTY;
 }
 
 void fuco_token_destruct(fuco_token_t *token) {
-    if (token->lexeme != NULL) {
-        free(token->lexeme);
-    }
     if (token->data != NULL) {
         free(token->data);
     }
@@ -297,15 +308,3 @@ char *fuco_token_string(fuco_token_t *token) {
 
     return fuco_tokentype_string(token->type);
 }
-
-char *fuco_token_static_string(fuco_token_t *token) {
-    static char *strs[16];
-    static size_t idx = 0;
-
-    char **str = &strs[idx];
-    *str = fuco_token_string(token);
-
-    idx = (idx + 1) % 16;
-
-    return *str;
-}
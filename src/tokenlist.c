@@ -74,3 +74,46 @@ fuco_tstream_t fuco_tokenlist_terminate(fuco_tokenlist_t *list) {
 
     return list->tokens;
 }
+
+void fuco_tokenarena_init(fuco_tokenarena_t *arena) {
+    arena->head = NULL;
+    arena->size = 0;
+}
+
+void fuco_tokenarena_destruct(fuco_tokenarena_t *arena) {
+    fuco_tokenchunk_t *chunk = arena->head, *next;
+
+    while (chunk != NULL) {
+        for (size_t i = 0; i < chunk->size; i++) {
+            fuco_token_destruct(&chunk->tokens[i]);
+        }
+
+        next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+
+    arena->head = NULL;
+    arena->size = 0;
+}
+
+fuco_token_t *fuco_tokenarena_add(fuco_tokenarena_t *arena, 
+                                  fuco_token_t *token) {
+    fuco_tokenchunk_t *chunk = arena->head;
+
+    if (chunk == NULL || chunk->size >= FUCO_TOKENARENA_CHUNK_SIZE) {
+        chunk = malloc(sizeof(fuco_tokenchunk_t));
+        chunk->next = arena->head;
+        chunk->size = 0;
+        arena->head = chunk;
+    }
+
+    fuco_token_t *pinned = &chunk->tokens[chunk->size];
+    *pinned = *token;
+    token->data = NULL;
+
+    chunk->size++;
+    arena->size++;
+
+    return pinned;
+}
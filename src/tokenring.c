@@ -0,0 +1,151 @@
+#include "tokenring.h"
+#include "utils.h"
+#include <assert.h>
+
+int fuco_tokenring_init(fuco_tokenring_t *ring, fuco_lexer_t *lexer, 
+                        bool threaded) {
+    ring->lexer = lexer;
+    ring->head = 0;
+    ring->shared_head = 0;
+    ring->done = ring->closed = false;
+    ring->threaded = threaded;
+
+    fuco_token_t *start = &ring->tokens[0];
+    fuco_token_init(start);
+    start->type = FUCO_TOKEN_START_OF_SOURCE;
+    ring->avail = ring->tail = ring->shared_tail = 1;
+
+    if (!threaded) {
+        return 0;
+    }
+
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->not_empty, NULL);
+    pthread_cond_init(&ring->not_full, NULL);
+
+    if (pthread_create(&ring->thread, NULL, fuco_tokenring_thread, ring)) {
+        fuco_syntax_error(NULL, "could not start lexer thread");
+
+        pthread_mutex_destroy(&ring->lock);
+        pthread_cond_destroy(&ring->not_empty);
+        pthread_cond_destroy(&ring->not_full);
+        ring->threaded = false;
+
+        return 1;
+    }
+
+    return 0;
+}
+
+void fuco_tokenring_destruct(fuco_tokenring_t *ring) {
+    if (ring->threaded) {
+        pthread_mutex_lock(&ring->lock);
+        ring->closed = true;
+        pthread_cond_signal(&ring->not_full);
+        pthread_mutex_unlock(&ring->lock);
+
+        pthread_join(ring->thread, NULL);
+
+        pthread_mutex_destroy(&ring->lock);
+        pthread_cond_destroy(&ring->not_empty);
+        pthread_cond_destroy(&ring->not_full);
+        ring->threaded = false;
+    }
+
+    for (size_t i = ring->head; i != ring->tail; i++) {
+        fuco_token_destruct(&ring->tokens[i & (FUCO_TOKENRING_SIZE - 1)]);
+    }
+
+    ring->head = ring->avail = ring->tail;
+}
+
+size_t fuco_tokenring_produce(fuco_tokenring_t *ring, size_t limit) {
+    while (ring->tail != limit && !ring->done) {
+        fuco_token_t *token;
+        token = &ring->tokens[ring->tail & (FUCO_TOKENRING_SIZE - 1)];
+
+        if (fuco_lexer_next_token(ring->lexer, token)) {
+            fuco_token_destruct(token);
+            token->type = FUCO_TOKEN_ERROR;
+        }
+
+        if (token->type == FUCO_TOKEN_END_OF_SOURCE 
+            || token->type == FUCO_TOKEN_ERROR) {
+            ring->done = true;
+        }
+
+        ring->tail++;
+    }
+
+    return ring->tail;
+}
+
+void *fuco_tokenring_thread(void *arg) {
+    fuco_tokenring_t *ring = arg;
+    size_t head;
+
+    pthread_mutex_lock(&ring->lock);
+
+    while (!ring->closed && !ring->done) {
+        while (ring->tail - ring->shared_head == FUCO_TOKENRING_SIZE 
+               && !ring->closed) {
+            pthread_cond_wait(&ring->not_full, &ring->lock);
+        }
+
+        head = ring->shared_head;
+        pthread_mutex_unlock(&ring->lock);
+
+        /* Lex in batches so the consumer sees tokens early */
+        size_t limit = FUCO_MIN(head + FUCO_TOKENRING_SIZE, 
+                                ring->tail + FUCO_TOKENRING_BATCH);
+        fuco_tokenring_produce(ring, limit);
+
+        pthread_mutex_lock(&ring->lock);
+        ring->shared_tail = ring->tail;
+        pthread_cond_signal(&ring->not_empty);
+    }
+
+    pthread_mutex_unlock(&ring->lock);
+
+    return NULL;
+}
+
+fuco_token_t *fuco_tokenring_peek(fuco_tokenring_t *ring) {
+    if (ring->head == ring->avail) {
+        if (ring->threaded) {
+            pthread_mutex_lock(&ring->lock);
+
+            ring->shared_head = ring->head;
+            pthread_cond_signal(&ring->not_full);
+
+            while (ring->shared_tail == ring->head) {
+                pthread_cond_wait(&ring->not_empty, &ring->lock);
+            }
+
+            ring->avail = ring->shared_tail;
+            pthread_mutex_unlock(&ring->lock);
+        } else {
+            ring->avail = fuco_tokenring_produce(ring, 
+                                                 ring->head 
+                                                 + FUCO_TOKENRING_SIZE);
+        }
+    }
+
+    assert(ring->head != ring->avail);
+
+    return &ring->tokens[ring->head & (FUCO_TOKENRING_SIZE - 1)];
+}
+
+void fuco_tokenring_release(fuco_tokenring_t *ring) {
+    assert(ring->head != ring->avail);
+
+    fuco_token_destruct(&ring->tokens[ring->head & (FUCO_TOKENRING_SIZE - 1)]);
+    ring->head++;
+
+    if (ring->threaded && ring->head % FUCO_TOKENRING_BATCH == 0) {
+        pthread_mutex_lock(&ring->lock);
+        ring->shared_head = ring->head;
+        pthread_cond_signal(&ring->not_full);
+        pthread_mutex_unlock(&ring->lock);
+    }
+}
@@ -0,0 +1,141 @@
+#include "trace.h"
+#include "utils.h"
+#include <errno.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+/* Crashes of the interpreter, followed by the request signal */
+int const fuco_trace_signals[] = { 
+    SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGUSR1 
+};
+
+#define FUCO_TRACE_N_SIGNALS FUCO_ARRAY_SIZE(fuco_trace_signals)
+
+fuco_trace_t *fuco_trace_active = NULL;
+int fuco_trace_fd = -1;
+struct sigaction fuco_trace_old_actions[FUCO_TRACE_N_SIGNALS];
+
+void fuco_trace_init(fuco_trace_t *trace) {
+    memset(trace, 0, sizeof(fuco_trace_t));
+    trace->magic = FUCO_TRACE_MAGIC;
+    trace->size = FUCO_TRACE_SIZE;
+}
+
+void fuco_trace_record(fuco_trace_t *trace, uint64_t ip, uint64_t sp) {
+    fuco_trace_entry_t *entry 
+            = &trace->entries[trace->head & (FUCO_TRACE_SIZE - 1)];
+
+    entry->ip = ip;
+    entry->sp = sp;
+    trace->head++;
+}
+
+int fuco_trace_install(fuco_trace_t *trace, int fd) {
+    struct sigaction action;
+
+    fuco_trace_active = trace;
+    fuco_trace_fd = fd;
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = fuco_trace_handle;
+    sigemptyset(&action.sa_mask);
+
+    for (size_t i = 0; i < FUCO_TRACE_N_SIGNALS; i++) {
+        /* Returning from a crash retries it under the default action */
+        action.sa_flags = fuco_trace_signals[i] == SIGUSR1 
+                          ? SA_RESTART : SA_RESETHAND;
+
+        if (sigaction(fuco_trace_signals[i], &action, 
+                      &fuco_trace_old_actions[i]) != 0) {
+            perror("sigaction");
+
+            while (i-- > 0) {
+                sigaction(fuco_trace_signals[i], &fuco_trace_old_actions[i], 
+                          NULL);
+            }
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void fuco_trace_uninstall(void) {
+    for (size_t i = 0; i < FUCO_TRACE_N_SIGNALS; i++) {
+        sigaction(fuco_trace_signals[i], &fuco_trace_old_actions[i], NULL);
+    }
+
+    fuco_trace_active = NULL;
+    fuco_trace_fd = -1;
+}
+
+void fuco_trace_handle(int signal) {
+    int saved = errno;
+
+    FUCO_UNUSED(signal);
+
+    if (fuco_trace_active != NULL) {
+        fuco_trace_dump(fuco_trace_active, fuco_trace_fd);
+    }
+
+    errno = saved;
+}
+
+int fuco_trace_dump(fuco_trace_t *trace, int fd) {
+    char const *data = (char const *)trace;
+    size_t left = sizeof(fuco_trace_t);
+
+    if (lseek(fd, 0, SEEK_SET) == -1) {
+        return 1;
+    }
+
+    while (left > 0) {
+        ssize_t n = write(fd, data, left);
+
+        if (n == -1 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            return 1;
+        }
+
+        data += n;
+        left -= n;
+    }
+
+    return 0;
+}
+
+int fuco_trace_read(fuco_trace_t *trace, FILE *file) {
+    if (fread(trace, sizeof(fuco_trace_t), 1, file) != 1) {
+        return 1;
+    }
+
+    return trace->magic != FUCO_TRACE_MAGIC || trace->size != FUCO_TRACE_SIZE;
+}
+
+void fuco_trace_write(fuco_trace_t *trace, fuco_bytecode_t *bytecode,
+                      fuco_ir_t *ir, FILE *file) {
+    uint64_t n = FUCO_MIN(trace->head, (uint64_t)FUCO_TRACE_SIZE);
+
+    fprintf(file, "last %lu of %lu calls, returns and taken branches\n", n, 
+            trace->head);
+    fprintf(file, "%10s %10s  %s\n", "ip", "sp", "function: instruction");
+
+    for (uint64_t i = trace->head - n; i < trace->head; i++) {
+        fuco_trace_entry_t *entry = &trace->entries[i & (FUCO_TRACE_SIZE - 1)];
+        fuco_ir_object_t *object = fuco_ir_object_at(ir, entry->ip);
+
+        fprintf(file, "%10lu %10lu  ", entry->ip, entry->sp);
+
+        if (object == NULL || entry->ip >= bytecode->size) {
+            fprintf(file, "?\n");
+            continue;
+        }
+
+        fuco_ir_object_write_name(object, file);
+        fprintf(file, ": ");
+        fuco_instr_write(bytecode->instrs[entry->ip], file);
+    }
+}
@@ -60,6 +60,9 @@ fuco_node_layout_t fuco_nodetype_get_layout(fuco_nodetype_t type) {
 
         case FUCO_NODE_TYPE_IDENTIFIER: 
             return FUCO_LAYOUT_TYPE_IDENTIFIER_N;
+
+        case FUCO_NODETYPES_N:
+            break;
     }
 
     FUCO_UNREACHED();
@@ -111,6 +114,9 @@ char *fuco_nodetype_get_label(fuco_nodetype_t type) {
 
         case FUCO_NODE_TYPE_IDENTIFIER: 
             return "type-identifier";
+
+        case FUCO_NODETYPES_N:
+            break;
     }
 
     FUCO_UNREACHED();
@@ -194,6 +200,86 @@ fuco_node_t *fuco_node_variadic_transform(fuco_node_t *node,
     return fuco_node_set_count(node, *allocated);;
 }
 
+void fuco_walker_init(fuco_walker_t *walker, fuco_walk_func_t visit, 
+                      void *data) {
+    walker->frames = walker->initial;
+    walker->size = 0;
+    walker->cap = FUCO_WALKER_INIT_SIZE;
+    walker->visit = visit;
+    walker->data = data;
+    walker->error = 0;
+}
+
+void fuco_walker_destruct(fuco_walker_t *walker) {
+    if (walker->frames != walker->initial) {
+        free(walker->frames);
+    }
+}
+
+fuco_walk_frame_t *fuco_walker_push(fuco_walker_t *walker, fuco_node_t *node) {
+    if (walker->size >= walker->cap) {
+        walker->cap *= 2;
+
+        if (walker->frames == walker->initial) {
+            walker->frames = malloc(walker->cap * sizeof(fuco_walk_frame_t));
+            memcpy(walker->frames, walker->initial, 
+                   walker->size * sizeof(fuco_walk_frame_t));
+        } else {
+            walker->frames = realloc(walker->frames, 
+                                     walker->cap * sizeof(fuco_walk_frame_t));
+        }
+    }
+
+    fuco_walk_frame_t *frame = &walker->frames[walker->size];
+
+    frame->node = node;
+    frame->step = 0;
+    frame->state[0] = frame->state[1] = 0;
+
+    if (walker->size > 0) {
+        frame->scope = frame[-1].scope;
+        frame->ctx = frame[-1].ctx;
+    } else {
+        frame->scope = NULL;
+        frame->ctx = NULL;
+    }
+
+    walker->size++;
+
+    return frame;
+}
+
+int fuco_walker_run(fuco_walker_t *walker, fuco_node_t *node, 
+                    fuco_scope_t *scope, fuco_node_t *ctx) {
+    fuco_walk_frame_t *frame = fuco_walker_push(walker, node);
+    frame->scope = scope;
+    frame->ctx = ctx;
+
+    while (walker->size > 0 && !walker->error) {
+        frame = &walker->frames[walker->size - 1];
+
+        fuco_node_t *child = walker->visit(walker, frame);
+
+        if (child == NULL) {
+            walker->size--;
+        } else {
+            /* Frame may move when the stack grows */
+            frame->step++;
+            fuco_walker_push(walker, child);
+        }
+    }
+
+    walker->size = 0;
+
+    return walker->error;
+}
+
+size_t fuco_walk_frame_child(fuco_walk_frame_t *frame) {
+    assert(frame->step > 0);
+
+    return frame->step - 1;
+}
+
 fuco_node_t *fuco_node_set_count(fuco_node_t *node, size_t count) {
     if (count > node->count) {
         node = realloc(node, FUCO_NODE_SIZE(count));
@@ -208,9 +294,18 @@ fuco_node_t *fuco_node_set_count(fuco_node_t *node, size_t count) {
     return node;
 }
 
-void fuco_node_free(fuco_node_t *node) {
-    if (node == NULL) {
-        return;
+fuco_node_t *fuco_node_free_visit(fuco_walker_t *walker, 
+                                  fuco_walk_frame_t *frame) {
+    fuco_node_t *node = frame->node;
+
+    FUCO_UNUSED(walker);
+
+    while (frame->step < node->count) {
+        if (node->children[frame->step] != NULL) {
+            return node->children[frame->step];
+        }
+
+        frame->step++;
     }
 
     switch (node->type) {
@@ -226,15 +321,23 @@ void fuco_node_free(fuco_node_t *node) {
             break;
     }
 
-    for (size_t i = 0; i < node->count; i++) {
-        if (node->children[i] != NULL) {
-            fuco_node_free(node->children[i]);
-        }
-    }
-
     if (node != &fuco_node_empty) {
         free(node);
     }
+
+    return NULL;
+}
+
+void fuco_node_free(fuco_node_t *node) {
+    fuco_walker_t walker;
+
+    if (node == NULL) {
+        return;
+    }
+
+    fuco_walker_init(&walker, fuco_node_free_visit, NULL);
+    fuco_walker_run(&walker, node, NULL, NULL);
+    fuco_walker_destruct(&walker);
 }
 
 fuco_node_t *fuco_node_add_child(fuco_node_t *node, fuco_node_t *child, 
@@ -278,14 +381,23 @@ void fuco_node_write(fuco_node_t *node, FILE *file) {
     fprintf(file, "]");
 }
 
-void fuco_node_pretty_write(fuco_node_t *node, FILE *file) {
-    static bool is_last[256];
-    static size_t depth = 0;
+fuco_node_t *fuco_node_pretty_write_visit(fuco_walker_t *walker, 
+                                          fuco_walk_frame_t *frame) {
+    fuco_node_t *node = frame->node;
+    FILE *file = walker->data;
 
-    assert(depth < 256);
+    if (frame->step > 0) {
+        return frame->step < node->count ? node->children[frame->step] : NULL;
+    }
+
+    size_t depth = frame - walker->frames;
 
     for (size_t i = 1; i < depth; i++) {
-        if (is_last[i - 1]) {
+        fuco_walk_frame_t *ancestor = &walker->frames[i - 1];
+        bool is_last = fuco_walk_frame_child(ancestor) 
+                       == ancestor->node->count - 1;
+
+        if (is_last) {
             fprintf(file, "    ");
         } else {
             fprintf(file, "│   ");
@@ -293,7 +405,11 @@ void fuco_node_pretty_write(fuco_node_t *node, FILE *file) {
     }
 
     if (depth > 0) {
-        if (is_last[depth - 1]) {
+        fuco_walk_frame_t *parent = &walker->frames[depth - 1];
+        bool is_last = fuco_walk_frame_child(parent) 
+                       == parent->node->count - 1;
+
+        if (is_last) {
             fprintf(file, "└───");
         } else {
             fprintf(file, "├───");
@@ -302,42 +418,44 @@ void fuco_node_pretty_write(fuco_node_t *node, FILE *file) {
 
     if (node == NULL) {
         fprintf(stderr, "(null)\n");
-    } else {
-        char *label = fuco_nodetype_get_label(node->type);
-        if (*label != '\0') {
-            fprintf(file, "%s", label);
-        }
+        return NULL;
+    }
 
-        if (node->token != NULL) {
-            fprintf(file, ": ");
-            fuco_token_write(node->token, file);
-        }
+    char *label = fuco_nodetype_get_label(node->type);
+    if (*label != '\0') {
+        fprintf(file, "%s", label);
+    }
 
-        if (node->symbol != NULL) {
-            fprintf(file, " (id=%d)", node->symbol->id);
-        }
+    if (node->token != NULL) {
+        fprintf(file, ": ");
+        fuco_token_write(node->token, file);
+    }
 
-        if (fuco_node_has_type(node)) {
-            fprintf(file, " :: ");
+    if (node->symbol != NULL) {
+        fprintf(file, " (id=%d)", node->symbol->id);
+    }
 
-            if (node->data.datatype == NULL) {
-                fprintf(stderr, "(nil)");
-            } else {
-                fuco_node_unparse_write(node->data.datatype, file);
-            }
+    if (fuco_node_has_type(node)) {
+        fprintf(file, " :: ");
+
+        if (node->data.datatype == NULL) {
+            fprintf(stderr, "(nil)");
+        } else {
+            fuco_node_unparse_write(node->data.datatype, file);
         }
-        
-        fprintf(file, "\n");
+    }
+    
+    fprintf(file, "\n");
 
-        depth++;
+    return node->count > 0 ? node->children[0] : NULL;
+}
 
-        for (size_t i = 0; i < node->count; i++) {
-            is_last[depth - 1] = i == node->count - 1;
-            fuco_node_pretty_write(node->children[i], file);
-        }
+void fuco_node_pretty_write(fuco_node_t *node, FILE *file) {
+    fuco_walker_t walker;
 
-        depth--;
-    }
+    fuco_walker_init(&walker, fuco_node_pretty_write_visit, file);
+    fuco_walker_run(&walker, node, NULL, NULL);
+    fuco_walker_destruct(&walker);
 }
 
 void fuco_node_unparse_write(fuco_node_t *node, FILE *file) {
@@ -345,6 +463,7 @@ void fuco_node_unparse_write(fuco_node_t *node, FILE *file) {
     
     switch (node->type) {
         case FUCO_NODE_EMPTY:
+        case FUCO_NODETYPES_N:
             FUCO_UNREACHED();
 
         case FUCO_NODE_FILEBODY:
@@ -494,6 +613,9 @@ bool fuco_node_has_type(fuco_node_t *node) {
         case FUCO_NODE_VARIABLE:
         case FUCO_NODE_INTEGER:
             return true;
+
+        case FUCO_NODETYPES_N:
+            break;
     }
 
     FUCO_UNREACHED();
@@ -506,7 +628,10 @@ bool fuco_node_type_equal(fuco_node_t *node, fuco_node_t *other) {
                 return false;
             }
 
-            return node->symbol->id == other->symbol->id;
+            assert(node->data.typeid != FUCO_TYPEID_INVALID);
+            assert(other->data.typeid != FUCO_TYPEID_INVALID);
+
+            return node->data.typeid == other->data.typeid;
         
         default:
             break;
@@ -515,24 +640,76 @@ bool fuco_node_type_equal(fuco_node_t *node, fuco_node_t *other) {
     FUCO_UNREACHED();    
 }
 
-void fuco_node_setup_scopes(fuco_node_t *node, fuco_scope_t *scope) {
-    fuco_scope_t *next;
+fuco_node_t *fuco_node_run_passes_visit(fuco_walker_t *walker, 
+                                        fuco_walk_frame_t *frame) {
+    fuco_pass_walk_t *state = walker->data;
+    fuco_node_t *node = frame->node;
+
+    /* The step only reaches a child after the first visit */
+    if (frame->step == 0) {
+        for (size_t i = 0; i < state->n_passes; i++) {
+            if (state->passes[i](frame, state->data)) {
+                walker->error = 1;
+                return NULL;
+            }
+        }
+    }
 
+    size_t size = state->size(node);
+
+    while (frame->step < size) {
+        if (node->children[frame->step] != NULL) {
+            return node->children[frame->step];
+        }
+
+        frame->step++;
+    }
+
+    return NULL;
+}
+
+int fuco_node_run_passes(fuco_node_t *node, fuco_walk_size_t size, 
+                         fuco_node_pass_t *passes, size_t n_passes, 
+                         void *data) {
+    fuco_pass_walk_t state;
+    fuco_walker_t walker;
+
+    state.size = size;
+    state.passes = passes;
+    state.n_passes = n_passes;
+    state.data = data;
+
+    fuco_walker_init(&walker, fuco_node_run_passes_visit, &state);
+    int error = fuco_walker_run(&walker, node, NULL, NULL);
+    fuco_walker_destruct(&walker);
+
+    return error;
+}
+
+int fuco_node_setup_scope(fuco_walk_frame_t *frame, void *data) {
+    fuco_node_t *node = frame->node;
+
+    /* Preorder guarantees that outer scopes are created before inner ones */
     switch (node->type) {
         case FUCO_NODE_FILEBODY:
         case FUCO_NODE_FUNCTION:
-            next = node->data.scope = malloc(sizeof(fuco_scope_t));
-            fuco_scope_init(node->data.scope, scope);
+            node->data.scope = malloc(sizeof(fuco_scope_t));
+            fuco_scope_init(node->data.scope, frame->scope);
+
+            /* Builtins must be declared before anything can refer to them */
+            if (node->data.scope->prev == NULL) {
+                fuco_symboltable_setup(data, node->data.scope);
+            }
+
+            /* Inherited by the children */
+            frame->scope = node->data.scope;
             break;
 
         default:
-            next = scope;
             break;
     }
 
-    for (size_t i = 0; i < node->count; i++) {
-        fuco_node_setup_scopes(node->children[i], next);
-    }
+    return 0;
 }
 
 fuco_scope_t *fuco_node_get_scope(fuco_node_t *node, fuco_scope_t *outer) {
@@ -554,24 +731,6 @@ fuco_scope_t *fuco_node_get_scope(fuco_node_t *node, fuco_scope_t *outer) {
     return scope;
 }
 
-int fuco_node_gather_datatypes(fuco_node_t *node, fuco_symboltable_t *table, 
-                                fuco_scope_t *outer) {
-    fuco_scope_t *scope = fuco_node_get_scope(node, outer);
-
-    switch (node->type) {
-        default:
-            break;
-    }
-
-    for (size_t i = 0; i < node->count; i++) {
-        if (fuco_node_gather_datatypes(node->children[i], table, scope)) {
-            return 1;
-        }
-    }
-
-    return 0;
-}
-
 int fuco_node_resolve_type(fuco_node_t *node, fuco_symboltable_t *table, 
                             fuco_scope_t *outer) {
     /* Types should not have nested scopes, tested in assertion */
@@ -591,6 +750,8 @@ int fuco_node_resolve_type(fuco_node_t *node, fuco_symboltable_t *table,
                 fuco_syntax_error(&node->token->source, "expected type");
                 return 1;
             }
+
+            node->data.typeid = node->symbol->typeid;
             break;
         
         default:
@@ -600,67 +761,103 @@ int fuco_node_resolve_type(fuco_node_t *node, fuco_symboltable_t *table,
     return 0;
 }
 
-int fuco_node_gather_functions(fuco_node_t *node, fuco_symboltable_t *table, 
-                                fuco_scope_t *outer) {
-    fuco_scope_t *scope = fuco_node_get_scope(node, outer);
-    fuco_node_t *params, *type, *rettype;
+int fuco_node_gather_function(fuco_walk_frame_t *frame, void *data) {
+    fuco_symboltable_t *table = data;
+    fuco_node_t *node = frame->node;
 
-    switch (node->type) {
-        case FUCO_NODE_FUNCTION:
-            node->symbol = fuco_symboltable_insert(table, outer, node->token, 
-                                                   node, FUCO_SYMBOL_FUNCTION);
-            if (node->symbol == NULL) {
-                return 1;
-            }
+    if (node->type != FUCO_NODE_FUNCTION) {
+        return 0;
+    }
 
-            params = node->children[FUCO_LAYOUT_FUNCTION_PARAMS];
-            if (fuco_node_gather_functions(params, table, scope)) {
-                return 1;
-            }
+    /* Scope setup ran first, the outer scope is the one it links to */
+    fuco_scope_t *scope = node->data.scope;
+    fuco_scope_t *outer = scope->prev;
 
-            rettype = node->children[FUCO_LAYOUT_FUNCTION_RET_TYPE];
-            if (fuco_node_resolve_type(rettype, table, outer)) {
-                return 1;
-            }
-            break;
+    node->symbol = fuco_symboltable_insert(table, outer, node->token, 
+                                           node, FUCO_SYMBOL_FUNCTION);
+    if (node->symbol == NULL) {
+        return 1;
+    }
 
-        case FUCO_NODE_PARAM:
-            node->symbol = fuco_symboltable_insert(table, scope, 
-                                                   node->token, node, 
-                                                   FUCO_SYMBOL_VARIABLE);
-            if (node->symbol == NULL) {
-                return 1;
-            }
-            
-            type = node->children[FUCO_LAYOUT_PARAM_TYPE];
-            if (fuco_node_resolve_type(type, table, scope)) {
-                return 1;
-            }
+    fuco_node_t *params = node->children[FUCO_LAYOUT_FUNCTION_PARAMS];
 
-            node->data.datatype = node->children[FUCO_LAYOUT_PARAM_TYPE];
-            break;
-            
-        default:     
-            for (size_t i = 0; i < node->count; i++) {
-                if (fuco_node_gather_functions(node->children[i], 
-                                                table, scope)) {
-                    return 1;
-                }
-            }
-            break;
+    for (size_t j = 0; j < params->count; j++) {
+        fuco_node_t *param = params->children[j];
+
+        param->symbol = fuco_symboltable_insert(table, scope, 
+                                                param->token, param, 
+                                                FUCO_SYMBOL_VARIABLE);
+        if (param->symbol == NULL) {
+            return 1;
+        }
+
+        fuco_node_t *type = param->children[FUCO_LAYOUT_PARAM_TYPE];
+        if (fuco_node_resolve_type(type, table, scope)) {
+            return 1;
+        }
+
+        param->data.datatype = type;
+    }
+
+    fuco_node_t *rettype = node->children[FUCO_LAYOUT_FUNCTION_RET_TYPE];
+    if (fuco_node_resolve_type(rettype, table, outer)) {
+        return 1;
     }
 
+    node->symbol->typeid = fuco_node_signature(node, &table->types);
+
     return 0;
 }
 
+size_t fuco_node_declare_walk_size(fuco_node_t *node) {
+    switch (node->type) {
+        case FUCO_NODE_FILEBODY:
+            return node->count;
+
+        default:
+            return 0;
+    }
+}
+
+int fuco_node_gather_globals(fuco_node_t *root, fuco_symboltable_t *table) {
+    fuco_node_pass_t passes[] = {
+        fuco_node_setup_scope,
+        fuco_node_gather_function
+    };
+
+    return fuco_node_run_passes(root, fuco_node_declare_walk_size, 
+                                passes, FUCO_ARRAY_SIZE(passes), table);
+}
+
+fuco_typeid_t fuco_node_signature(fuco_node_t *node, fuco_typetable_t *types) {
+    assert(node->type == FUCO_NODE_FUNCTION);
+
+    fuco_node_t *params = node->children[FUCO_LAYOUT_FUNCTION_PARAMS];
+    fuco_node_t *rettype = node->children[FUCO_LAYOUT_FUNCTION_RET_TYPE];
+    fuco_typeid_t *param_types = malloc(params->count * sizeof(fuco_typeid_t));
+
+    for (size_t i = 0; i < params->count; i++) {
+        fuco_node_t *param = params->children[i];
+        param_types[i] = param->children[FUCO_LAYOUT_PARAM_TYPE]->data.typeid;
+    }
+
+    fuco_typeid_t id = fuco_typetable_function(types, rettype->data.typeid, 
+                                               param_types, params->count);
+
+    free(param_types);
+
+    return id;
+}
+
 int fuco_node_coerce_type(fuco_node_t **pnode, fuco_node_t *type, 
-                          fuco_scope_t *scope) {    
+                          fuco_symboltable_t *table) {
     fuco_node_t *node = *pnode;
     assert(node->data.datatype != NULL);
 
     fuco_symbol_t *conv;
     if (!fuco_node_type_equal(node->data.datatype, type)) {
-        conv = fuco_scope_lookup_conversion(scope, node->data.datatype, type);
+        conv = fuco_symboltable_lookup_conversion(table, node->data.datatype, 
+                                                  type);
         
         if (conv == NULL) {
             /* TODO better syntax error */
@@ -680,38 +877,9 @@ int fuco_node_coerce_type(fuco_node_t **pnode, fuco_node_t *type,
     return 0;
 }
 
-int fuco_node_resolve_local_propagate(fuco_node_t *node, 
-                                      fuco_symboltable_t *table, 
-                                      fuco_scope_t *scope, fuco_node_t *ctx) {
-    for (size_t i = 0; i < node->count; i++) {
-        if (fuco_node_resolve_local(node->children[i], table, scope, ctx)) {
-            return 1;
-        }
-    }
-
-    return 0;
-}
-
-int fuco_node_resolve_local_function(fuco_node_t *node, 
-                                     fuco_symboltable_t *table, 
-                                     fuco_scope_t *scope) {
-    assert(node->type == FUCO_NODE_FUNCTION);
-    
-    fuco_function_def_t *def = NULL;
-    node->symbol->value = def;
-    
-    fuco_node_t *next = node->children[FUCO_LAYOUT_FUNCTION_BODY];
-    return fuco_node_resolve_local_propagate(next, table, scope, node);
-}
-
 int fuco_node_resolve_local_call(fuco_node_t *node, fuco_symboltable_t *table, 
-                                 fuco_scope_t *scope, fuco_node_t *ctx) {
-    
+                                 fuco_scope_t *scope) {
     assert(node->type == FUCO_NODE_CALL);
-    
-    if (fuco_node_resolve_local_propagate(node, table, scope, ctx)) {
-        return 1;
-    }
 
     /* FUTURE: enable subscopes to extend overloads instead of only 
        considering most recent overloads */
@@ -760,22 +928,22 @@ int fuco_node_resolve_local_call(fuco_node_t *node, fuco_symboltable_t *table,
     fuco_node_t *args = node->children[FUCO_LAYOUT_CALL_ARGS];
 
     while (symbol != NULL) {
-        fuco_node_t *func = symbol->def;
-        fuco_node_t *params = func->children[FUCO_LAYOUT_FUNCTION_PARAMS];
+        fuco_type_t *signature = fuco_typetable_get(&table->types, 
+                                                    symbol->typeid);
+        /* Return type followed by parameter types */
+        fuco_typeid_t *param_types = fuco_typetable_get_args(&table->types, 
+                                                             symbol->typeid);
         bool match = true, arg_match;
 
-        fuco_node_t *arg_type, *param, *param_type;
+        fuco_node_t *arg_type;
 
-        if (args->count == params->count) {
+        if (args->count + 1 == signature->n_args) {
             for (size_t i = 0; i < args->count; i++) {
                 arg_type = args->children[i]->data.datatype;
-                param = params->children[i];
-                param_type = param->children[FUCO_LAYOUT_PARAM_TYPE];
 
                 assert(arg_type != NULL);
-                assert(param_type != NULL);
 
-                arg_match = fuco_node_type_equal(arg_type, param_type);
+                arg_match = arg_type->data.typeid == param_types[i + 1];
                 
                 match = match && arg_match;
 
@@ -825,74 +993,48 @@ int fuco_node_resolve_local_call(fuco_node_t *node, fuco_symboltable_t *table,
     return 0;
 }
 
-int fuco_node_resolve_instr(fuco_node_t *node, fuco_symboltable_t *table,
-                            fuco_scope_t *scope, fuco_node_t *ctx) {
+int fuco_node_resolve_instr_arity(fuco_node_t *node) {
     assert(node->type == FUCO_NODE_INSTR);
     assert(node->opcode != FUCO_OPCODE_NOP);
 
-    if (fuco_node_resolve_local_propagate(node, table, scope, ctx)) {
-        return 1;
-    }
-
     fuco_node_t *args = node->children[FUCO_LAYOUT_INSTR_ARGS];
 
     size_t arity = fuco_opcode_get_arity(node->opcode);
     if (args->count != arity) {
         fuco_syntax_error(&node->token->source, 
                           "%s expects %ld arguments, but got %ld", 
-                          fuco_token_string(node->token), arity, node->count);
+                          fuco_token_string(node->token), arity, args->count);
         return 1;
     }
 
-    for (size_t i = 0; i < arity; i++) {
-        fuco_node_t *type = fuco_opcode_get_argtype(node->opcode, table, i);
-
-        if (fuco_node_coerce_type(&args->children[i], type, scope)) {
-            return 1;
-        }
-    }
-
-    node->data.datatype = fuco_opcode_get_rettype(node->opcode, table);;
-
     return 0;
 }
 
-int fuco_node_resolve_local(fuco_node_t *node, fuco_symboltable_t *table, 
-                            fuco_scope_t *outer, fuco_node_t *ctx) {        
-    fuco_scope_t *scope = fuco_node_get_scope(node, outer);
-    
-    fuco_node_t *type;
+int fuco_node_resolve_local_node(fuco_node_t *node, fuco_symboltable_t *table, 
+                                 fuco_scope_t *scope, fuco_node_t *ctx) {
+    FUCO_UNUSED(ctx);
 
     switch (node->type) {
         case FUCO_NODE_EMPTY:
-        case FUCO_NODE_PARAM_LIST:
-        case FUCO_NODE_PARAM:
-            break;
-
         case FUCO_NODE_FILEBODY:
         case FUCO_NODE_BODY:
-        case FUCO_NODE_ARG_LIST:
-            if (fuco_node_resolve_local_propagate(node, table, scope, ctx)) {
-                return 1;
-            }
-            break;
-
         case FUCO_NODE_FUNCTION:
-            if (fuco_node_resolve_local_function(node, table, scope)) {
-                return 1;
-            }
+        case FUCO_NODE_PARAM_LIST:
+        case FUCO_NODE_PARAM:
+        case FUCO_NODE_ARG_LIST:
+        case FUCO_NODE_RETURN: /* Coerced by fuco_node_analyze_coerce */
+        case FUCO_NODE_IF_ELSE:
+        case FUCO_NODE_WHILE:
             break;
 
         case FUCO_NODE_CALL:
-            if (fuco_node_resolve_local_call(node, table, scope, ctx)) {
+            if (fuco_node_resolve_local_call(node, table, scope)) {
                 return 1;
             }
             break;
 
         case FUCO_NODE_INSTR:
-            if (fuco_node_resolve_instr(node, table, scope, ctx)) {
-                return 1;
-            }
+            node->data.datatype = fuco_opcode_get_rettype(node->opcode, table);
             break;
 
         case FUCO_NODE_VARIABLE:
@@ -914,29 +1056,6 @@ int fuco_node_resolve_local(fuco_node_t *node, fuco_symboltable_t *table,
                                                             FUCO_SYMID_INT);
             break;
 
-        case FUCO_NODE_RETURN:
-            if (fuco_node_resolve_local_propagate(node, table, scope, ctx)) {
-                return 1;
-            }
-
-            type = ctx->children[FUCO_LAYOUT_FUNCTION_RET_TYPE];
-            if (fuco_node_coerce_type(&node->children[FUCO_LAYOUT_RETURN_VALUE], 
-                                      type, scope)) {
-                return 1;
-            }
-            break;
-
-        case FUCO_NODE_IF_ELSE:
-            if (fuco_node_resolve_local_propagate(node, table, scope, ctx)) {
-                return 1;
-            }
-            break;
-
-        case FUCO_NODE_WHILE:
-            if (fuco_node_resolve_local_propagate(node, table, scope, ctx)) {
-                return 1;
-            }
-            break;
 
         case FUCO_NODE_TYPE_IDENTIFIER:
             node->symbol = fuco_scope_lookup_token(scope, node->token);
@@ -948,108 +1067,166 @@ int fuco_node_resolve_local(fuco_node_t *node, fuco_symboltable_t *table,
                 fuco_syntax_error(&node->token->source, "expected type");
                 return 1;
             }
+
+            node->data.typeid = node->symbol->typeid;
             break;
+
+        case FUCO_NODETYPES_N:
+            FUCO_UNREACHED();
     }
     
     return 0;
 }
 
-void fuco_node_generate_ir_propagate(fuco_node_t *node, fuco_ir_t *ir, 
-                                     size_t obj) {
-    for (size_t i = 0; i < node->count; i++) {
-        fuco_node_generate_ir(node->children[i], ir, obj);
+void fuco_node_resolve_local_enter(fuco_walk_frame_t *frame) {
+    fuco_node_t *node = frame->node;
+
+    frame->scope = fuco_node_get_scope(node, frame->scope);
+
+    if (node->type == FUCO_NODE_FUNCTION) {
+        fuco_function_def_t *def = NULL;
+        node->symbol->value = def;
+        frame->ctx = node;
     }
 }
 
-void fuco_node_generate_ir_if_else(fuco_node_t *node, fuco_ir_t *ir, 
-                                   size_t obj) {
+fuco_node_t *fuco_node_generate_ir_if_else(fuco_walk_frame_t *frame, 
+                                           fuco_ir_t *ir, size_t obj) {
+    fuco_node_t *node = frame->node;
+    fuco_ir_label_t *label_end = &frame->state[0];
+    fuco_ir_label_t *label_false = &frame->state[1];
+
     assert(node->type == FUCO_NODE_IF_ELSE);
 
-    fuco_ir_label_t label_end = fuco_ir_next_label(ir);
-    fuco_ir_label_t label_false = fuco_ir_next_label(ir);
+    switch (frame->step) {
+        case 0:
+            *label_end = fuco_ir_next_label(ir, obj);
+            *label_false = fuco_ir_next_label(ir, obj);
+
+            return node->children[FUCO_LAYOUT_IF_ELSE_COND];
 
-    fuco_node_t *cond = node->children[FUCO_LAYOUT_IF_ELSE_COND];
-    fuco_node_generate_ir(cond, ir, obj);
+        case 1:
+            fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_BRFALSE, 
+                                          *label_false);
 
-    fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_BRFALSE, label_false);
+            return node->children[FUCO_LAYOUT_IF_ELSE_TRUE_BODY];
 
-    fuco_node_t *true_body = node->children[FUCO_LAYOUT_IF_ELSE_TRUE_BODY];
-    fuco_node_generate_ir(true_body, ir, obj);
-    fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_JUMP, label_end);
+        case 2:
+            fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_JUMP, 
+                                          *label_end);
 
-    fuco_ir_add_label(ir, obj, label_false);
+            fuco_ir_add_label(ir, obj, *label_false);
 
-    fuco_node_t *false_body = node->children[FUCO_LAYOUT_IF_ELSE_FALSE_BODY];
-    fuco_node_generate_ir(false_body, ir, obj);
+            return node->children[FUCO_LAYOUT_IF_ELSE_FALSE_BODY];
 
-    fuco_ir_add_label(ir, obj, label_end);
+        default:
+            fuco_ir_add_label(ir, obj, *label_end);
+
+            return NULL;
+    }
 }
 
-void fuco_node_generate_ir_while(fuco_node_t *node, fuco_ir_t *ir, 
-                                 size_t obj) {
+fuco_node_t *fuco_node_generate_ir_while(fuco_walk_frame_t *frame, 
+                                         fuco_ir_t *ir, size_t obj) {
+    fuco_node_t *node = frame->node;
+    fuco_ir_label_t *label_repeat = &frame->state[0];
+    fuco_ir_label_t *label_end = &frame->state[1];
+
     assert(node->type == FUCO_NODE_WHILE);
 
-    fuco_ir_label_t label_repeat = fuco_ir_next_label(ir);
-    fuco_ir_label_t label_end = fuco_ir_next_label(ir);
+    switch (frame->step) {
+        case 0:
+            *label_repeat = fuco_ir_next_label(ir, obj);
+            *label_end = fuco_ir_next_label(ir, obj);
+
+            fuco_ir_add_label(ir, obj, *label_repeat);
 
-    fuco_ir_add_label(ir, obj, label_repeat);
+            return node->children[FUCO_LAYOUT_WHILE_COND];
 
-    fuco_node_t *cond = node->children[FUCO_LAYOUT_WHILE_COND];
-    fuco_node_generate_ir(cond, ir, obj);
-    fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_BRFALSE, label_end);
+        case 1:
+            fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_BRFALSE, 
+                                          *label_end);
 
-    fuco_node_t *body = node->children[FUCO_LAYOUT_WHILE_BODY];
-    fuco_node_generate_ir(body, ir, obj);
+            return node->children[FUCO_LAYOUT_WHILE_BODY];
 
-    fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_JUMP, label_repeat);
+        default:
+            fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_JUMP, 
+                                          *label_repeat);
 
-    fuco_ir_add_label(ir, obj, label_end);
+            fuco_ir_add_label(ir, obj, *label_end);
+
+            return NULL;
+    }
 }
 
+void fuco_node_create_objects(fuco_node_t *node, fuco_ir_t *ir) {
+    switch (node->type) {
+        case FUCO_NODE_FILEBODY:
+            for (size_t i = 0; i < node->count; i++) {
+                fuco_node_create_objects(node->children[i], ir);
+            }
+            break;
+
+        case FUCO_NODE_FUNCTION:
+            node->symbol->obj = fuco_ir_add_object(ir, node->symbol->id, 
+                                                   node);
+            break;
+
+        default:
+            break;
+    }
+}
 
-void fuco_node_generate_ir(fuco_node_t *node, fuco_ir_t *ir, 
-                           size_t obj) {
-    fuco_node_t *next = NULL;
+fuco_node_t *fuco_node_generate_ir_step(fuco_walk_frame_t *frame, 
+                                        fuco_ir_walk_t *state) {
+    fuco_node_t *node = frame->node;
+    fuco_ir_t *ir = state->ir;
+    size_t obj = state->obj;
 
     switch (node->type) {
         case FUCO_NODE_EMPTY:
         case FUCO_NODE_PARAM_LIST:
         case FUCO_NODE_PARAM:
         case FUCO_NODE_TYPE_IDENTIFIER:
+        case FUCO_NODETYPES_N:
             break;
 
         case FUCO_NODE_FILEBODY:
         case FUCO_NODE_BODY:
-            fuco_node_generate_ir_propagate(node, ir, obj);
+            if (frame->step < node->count) {
+                return node->children[frame->step];
+            }
             break;
 
         case FUCO_NODE_FUNCTION:
-            node->symbol->obj = fuco_ir_add_object(ir, node->symbol->id, 
-                                                   node);
+            if (frame->step == 0) {
+                state->obj = node->symbol->obj;
 
-            next = node->children[FUCO_LAYOUT_FUNCTION_BODY];
-            fuco_node_generate_ir(next, ir, node->symbol->obj);
+                return node->children[FUCO_LAYOUT_FUNCTION_BODY];
+            }
             break;
 
         case FUCO_NODE_CALL:
-            next = node->children[FUCO_LAYOUT_CALL_ARGS];
-            fuco_node_generate_ir(next, ir, obj);
+            if (frame->step == 0) {
+                return node->children[FUCO_LAYOUT_CALL_ARGS];
+            }
 
             fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_CALL, 
                                           node->symbol->id);
             break;
 
         case FUCO_NODE_INSTR:
-            next = node->children[FUCO_LAYOUT_INSTR_ARGS];
-            fuco_node_generate_ir(next, ir, obj);
+            if (frame->step == 0) {
+                return node->children[FUCO_LAYOUT_INSTR_ARGS];
+            }
 
             fuco_ir_add_instr(ir, obj, node->opcode);
             break;
 
         case FUCO_NODE_ARG_LIST:
             /* Arguments are pushed in reverse order */
-            for (size_t i = node->count; i > 0; i--) {
-                fuco_node_generate_ir(node->children[i - 1], ir, obj);
+            if (frame->step < node->count) {
+                return node->children[node->count - 1 - frame->step];
             }
             break;
 
@@ -1064,19 +1241,122 @@ void fuco_node_generate_ir(fuco_node_t *node, fuco_ir_t *ir,
             break;
 
         case FUCO_NODE_RETURN:
-            fuco_node_generate_ir_propagate(node, ir, obj);
+            if (frame->step < node->count) {
+                return node->children[frame->step];
+            }
+
             fuco_ir_add_instr_imm48_label(ir, obj, FUCO_OPCODE_QRET, 
                                           ir->objects[obj].paramsize_label);
             break;
 
         case FUCO_NODE_IF_ELSE:
-            fuco_node_generate_ir_if_else(node, ir, obj);
-            break;
+            return fuco_node_generate_ir_if_else(frame, ir, obj);
 
         case FUCO_NODE_WHILE:
-            fuco_node_generate_ir_while(node, ir, obj);
-            break;
+            return fuco_node_generate_ir_while(frame, ir, obj);
+    }
+
+    return NULL;
+}
+
+size_t fuco_node_walk_size(fuco_node_t *node) {
+    switch (node->type) {
+        case FUCO_NODE_FILEBODY:
+        case FUCO_NODE_BODY:
+        case FUCO_NODE_CALL:
+        case FUCO_NODE_INSTR:
+        case FUCO_NODE_ARG_LIST:
+        case FUCO_NODE_RETURN:
+        case FUCO_NODE_IF_ELSE:
+        case FUCO_NODE_WHILE:
+            return node->count;
+
+        case FUCO_NODE_FUNCTION:
+            return 1; /* Only the body */
+
+        default:
+            return 0;
+    }
+}
+
+int fuco_node_analyze_coerce(fuco_analysis_t *analysis, fuco_node_t **pnode, 
+                             fuco_node_t *type) {
+    fuco_node_t *node = *pnode;
+
+    if (fuco_node_coerce_type(pnode, type, analysis->table)) {
+        return 1;
+    }
+
+    /* Code for the operand is already generated, the conversion follows */
+    if (*pnode != node) {
+        fuco_ir_add_instr_imm48_label(analysis->ir.ir, analysis->ir.obj, 
+                                      FUCO_OPCODE_CALL, (*pnode)->symbol->id);
+    }
+
+    return 0;
+}
+
+fuco_node_t *fuco_node_analyze_visit(fuco_walker_t *walker, 
+                                     fuco_walk_frame_t *frame) {
+    fuco_analysis_t *analysis = walker->data;
+    fuco_symboltable_t *table = analysis->table;
+    fuco_node_t *node = frame->node;
+    fuco_node_t *type;
+
+    if (frame->step == 0) {
+        fuco_node_resolve_local_enter(frame);
+
+        if (node->type == FUCO_NODE_INSTR 
+            && fuco_node_resolve_instr_arity(node)) {
+            walker->error = 1;
+            return NULL;
+        }
+    } else if (node->type == FUCO_NODE_ARG_LIST && frame > walker->frames
+               && frame[-1].node->type == FUCO_NODE_INSTR) {
+        /* Arguments are generated last to first */
+        size_t i = node->count - frame->step;
+        type = fuco_opcode_get_argtype(frame[-1].node->opcode, table, i);
+
+        if (fuco_node_analyze_coerce(analysis, &node->children[i], type)) {
+            walker->error = 1;
+            return NULL;
+        }
     }
+
+    if (frame->step == fuco_node_walk_size(node)) {
+        if (node->type == FUCO_NODE_RETURN) {
+            fuco_node_t **value = &node->children[FUCO_LAYOUT_RETURN_VALUE];
+            type = frame->ctx->children[FUCO_LAYOUT_FUNCTION_RET_TYPE];
+
+            walker->error = fuco_node_analyze_coerce(analysis, value, type);
+        } else {
+            walker->error = fuco_node_resolve_local_node(node, table, 
+                                                         frame->scope, 
+                                                         frame->ctx);
+        }
+
+        if (walker->error) {
+            return NULL;
+        }
+    }
+
+    return fuco_node_generate_ir_step(frame, &analysis->ir);
+}
+
+int fuco_node_analyze(fuco_node_t *node, fuco_symboltable_t *table, 
+                      fuco_ir_t *ir, size_t obj) {
+    fuco_analysis_t analysis;
+    fuco_walker_t walker;
+
+    analysis.table = table;
+    analysis.ir.ir = ir;
+    analysis.ir.obj = obj;
+
+    fuco_walker_init(&walker, fuco_node_analyze_visit, &analysis);
+    int error = fuco_walker_run(&walker, node, NULL, NULL);
+    fuco_walker_destruct(&walker);
+
+    return error;
 }
 
  /* FIXME improve */
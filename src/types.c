@@ -0,0 +1,191 @@
+#include "types.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+void fuco_typetable_init(fuco_typetable_t *types) {
+    types->cap = FUCO_TYPETABLE_INIT_SIZE;
+    types->types = malloc(types->cap * sizeof(fuco_type_t));
+    types->size = 1;
+
+    types->types[FUCO_TYPEID_INVALID].kind = FUCO_TYPEKIND_NULL;
+    types->types[FUCO_TYPEID_INVALID].symbol = 0;
+    types->types[FUCO_TYPEID_INVALID].index = 0;
+    types->types[FUCO_TYPEID_INVALID].args = 0;
+    types->types[FUCO_TYPEID_INVALID].n_args = 0;
+
+    memset(types->counts, 0, sizeof(types->counts));
+    types->counts[FUCO_TYPEKIND_NULL] = 1;
+
+    types->pool_cap = FUCO_TYPETABLE_INIT_SIZE;
+    types->pool = malloc(types->pool_cap * sizeof(fuco_typeid_t));
+    types->pool_size = 0;
+
+    types->cap_buckets = 2 * FUCO_TYPETABLE_INIT_SIZE;
+    types->buckets = calloc(types->cap_buckets, sizeof(fuco_typeid_t));
+}
+
+void fuco_typetable_destruct(fuco_typetable_t *types) {
+    free(types->types);
+    free(types->pool);
+    free(types->buckets);
+}
+
+void fuco_typetable_write(fuco_typetable_t *types, FILE *file) {
+    static char *kinds[] = { "null", "named", "array", "function", "generic" };
+
+    for (size_t i = 1; i < types->size; i++) {
+        fuco_type_t *type = &types->types[i];
+
+        fprintf(file, " %*ld: %s %d (", fuco_ceil_log(types->size, 10), 
+                i, kinds[type->kind], type->symbol);
+
+        for (size_t j = 0; j < type->n_args; j++) {
+            fprintf(file, j == 0 ? "%d" : ", %d", types->pool[type->args + j]);
+        }
+
+        fprintf(file, ")\n");
+    }
+}
+
+fuco_hashvalue_t fuco_type_hash(fuco_typekind_t kind, uint32_t symbol, 
+                                fuco_typeid_t *args, size_t n_args) {
+    fuco_hashvalue_t hash = 14695981039346656037ULL;
+
+    hash = (hash ^ kind) * 1099511628211ULL;
+    hash = (hash ^ symbol) * 1099511628211ULL;
+
+    for (size_t i = 0; i < n_args; i++) {
+        hash = (hash ^ args[i]) * 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+bool fuco_type_equal(fuco_typetable_t *types, fuco_typeid_t id, 
+                     fuco_typekind_t kind, uint32_t symbol, 
+                     fuco_typeid_t *args, size_t n_args) {
+    fuco_type_t *type = &types->types[id];
+
+    return type->kind == kind && type->symbol == symbol 
+           && type->n_args == n_args
+           && (n_args == 0 
+               || memcmp(&types->pool[type->args], args, 
+                         n_args * sizeof(fuco_typeid_t)) == 0);
+}
+
+void fuco_typetable_rehash(fuco_typetable_t *types) {
+    free(types->buckets);
+
+    types->cap_buckets *= 2;
+    types->buckets = calloc(types->cap_buckets, sizeof(fuco_typeid_t));
+
+    for (size_t id = 1; id < types->size; id++) {
+        fuco_type_t *type = &types->types[id];
+        fuco_hashvalue_t hash = fuco_type_hash(type->kind, type->symbol, 
+                                               &types->pool[type->args], 
+                                               type->n_args);
+        size_t idx = hash & (types->cap_buckets - 1);
+
+        while (types->buckets[idx] != FUCO_TYPEID_INVALID) {
+            idx = (idx + 1) & (types->cap_buckets - 1);
+        }
+
+        types->buckets[idx] = id;
+    }
+}
+
+fuco_typeid_t fuco_typetable_intern(fuco_typetable_t *types, 
+                                    fuco_typekind_t kind, uint32_t symbol, 
+                                    fuco_typeid_t *args, size_t n_args) {
+    fuco_hashvalue_t hash = fuco_type_hash(kind, symbol, args, n_args);
+    size_t idx = hash & (types->cap_buckets - 1);
+
+    while (types->buckets[idx] != FUCO_TYPEID_INVALID) {
+        fuco_typeid_t id = types->buckets[idx];
+
+        if (fuco_type_equal(types, id, kind, symbol, args, n_args)) {
+            return id;
+        }
+
+        idx = (idx + 1) & (types->cap_buckets - 1);
+    }
+
+    if (types->size >= types->cap) {
+        types->cap *= 2;
+        types->types = realloc(types->types, 
+                               types->cap * sizeof(fuco_type_t));
+    }
+
+    if (types->pool_size + n_args > types->pool_cap) {
+        while (types->pool_size + n_args > types->pool_cap) {
+            types->pool_cap *= 2;
+        }
+        types->pool = realloc(types->pool, 
+                              types->pool_cap * sizeof(fuco_typeid_t));
+    }
+
+    fuco_typeid_t id = types->size;
+    fuco_type_t *type = &types->types[id];
+
+    type->kind = kind;
+    type->symbol = symbol;
+    type->index = types->counts[kind]++;
+    type->args = types->pool_size;
+    type->n_args = n_args;
+
+    if (n_args > 0) {
+        memcpy(&types->pool[type->args], args, 
+               n_args * sizeof(fuco_typeid_t));
+    }
+    types->pool_size += n_args;
+    types->size++;
+
+    types->buckets[idx] = id;
+
+    /* Load factor of at most 0.5 keeps probe sequences short */
+    if (2 * types->size >= types->cap_buckets) {
+        fuco_typetable_rehash(types);
+    }
+
+    return id;
+}
+
+fuco_typeid_t fuco_typetable_named(fuco_typetable_t *types, uint32_t symbol) {
+    return fuco_typetable_intern(types, FUCO_TYPEKIND_NAMED, symbol, NULL, 0);
+}
+
+fuco_typeid_t fuco_typetable_array(fuco_typetable_t *types, 
+                                   fuco_typeid_t element) {
+    return fuco_typetable_intern(types, FUCO_TYPEKIND_ARRAY, 0, &element, 1);
+}
+
+fuco_typeid_t fuco_typetable_function(fuco_typetable_t *types, 
+                                      fuco_typeid_t ret, 
+                                      fuco_typeid_t *params, size_t n_params) {
+    fuco_typeid_t *args = malloc((n_params + 1) * sizeof(fuco_typeid_t));
+
+    args[0] = ret;
+    if (n_params > 0) {
+        memcpy(&args[1], params, n_params * sizeof(fuco_typeid_t));
+    }
+
+    fuco_typeid_t id = fuco_typetable_intern(types, FUCO_TYPEKIND_FUNCTION, 0, 
+                                             args, n_params + 1);
+
+    free(args);
+
+    return id;
+}
+
+fuco_type_t *fuco_typetable_get(fuco_typetable_t *types, fuco_typeid_t id) {
+    assert(id != FUCO_TYPEID_INVALID && id < types->size);
+
+    return &types->types[id];
+}
+
+fuco_typeid_t *fuco_typetable_get_args(fuco_typetable_t *types, 
+                                       fuco_typeid_t id) {
+    return &types->pool[fuco_typetable_get(types, id)->args];
+}
@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,6 +13,8 @@ void fuco_fatal_error(char const *file, int line, char const *msg) {
 }
 
 void fuco_syntax_error(fuco_textsource_t *source, char const *format, ...) {
+    flockfile(stderr); /* Keep messages from worker threads whole */
+
     fprintf(stderr, FUCO_ANSI_RED "Error: ");
 
     if (source != NULL) {
@@ -26,6 +30,8 @@ void fuco_syntax_error(fuco_textsource_t *source, char const *format, ...) {
     va_end(args);
 
     fprintf(stderr, "\n" FUCO_ANSI_RESET);
+
+    funlockfile(stderr);
 }
 
 char fuco_base_char(int i) {
@@ -38,15 +44,9 @@ char fuco_base_char(int i) {
     }
 }
 
-char *fuco_repr_char(char c) {
-    static char bufs[16][5];
-    static size_t idx = 0;
-
-    char *buf = bufs[idx];
+char *fuco_repr_char(char c, char *buf) {
     unsigned char b = c;
 
-    idx = (idx + 1) % 16;
-
     if (isprint(b)) {
         buf[0] = c;
         buf[1] = '\0';
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Generates large, valid Fulcrum programs for compile scaling tests. Output
+   depends only on the options, so a seed reproduces a program exactly.
+   Nesting is written iteratively, any depth the parser accepts can be
+   generated */
+
+#define FCGEN_MAX_ARITY 8
+
+/* Deeper levels are not indented further, keeping output linear in depth */
+#define FCGEN_MAX_INDENT 16
+
+typedef struct {
+    uint64_t seed;
+    size_t n_functions; /* Functions calling earlier ones */
+    size_t n_overloads; /* Signatures in one overload set */
+    size_t chain; /* Terms per expression */
+    size_t depth; /* Nested if/while per function */
+    char const *output;
+} fcgen_options_t;
+
+typedef struct {
+    FILE *file;
+    uint64_t state;
+    fcgen_options_t *options;
+} fcgen_t;
+
+static char const *const fcgen_operators[] = {
+    "+", "-", "*", "/", "%", "==", "!=", "<", "<=", ">", ">="
+};
+
+static char const *const fcgen_mnemonics[] = {
+    "iadd", "isub", "imul", "idiv", "imod", "ieq", "ine", "ilt", "ile",
+    "igt", "ige"
+};
+
+#define FCGEN_N_OPERATORS (sizeof(fcgen_operators) / sizeof(*fcgen_operators))
+
+uint64_t fcgen_random(fcgen_t *gen) {
+    uint64_t x = gen->state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    return gen->state = x;
+}
+
+size_t fcgen_below(fcgen_t *gen, size_t n) {
+    return fcgen_random(gen) % n;
+}
+
+/* Signature i of the overload set: arity and one bit per parameter, set
+   for Float */
+void fcgen_signature(size_t i, size_t *arity, unsigned *floats) {
+    size_t n = 1;
+
+    while (i >= ((size_t)1 << n)) {
+        i -= (size_t)1 << n;
+        n++;
+    }
+
+    *arity = n;
+    *floats = i;
+}
+
+void fcgen_prelude(fcgen_t *gen) {
+    fprintf(gen->file,
+            "def convert(x: Int) -> Float {\n"
+            "    return %%itof(x);\n"
+            "}\n\n");
+
+    for (size_t i = 0; i < FCGEN_N_OPERATORS; i++) {
+        fprintf(gen->file,
+                "def inline [ %s ](x: Int, y: Int) -> Int {\n"
+                "    return %%%s(x, y);\n"
+                "}\n\n", fcgen_operators[i], fcgen_mnemonics[i]);
+    }
+}
+
+void fcgen_overloads(fcgen_t *gen) {
+    for (size_t i = 0; i < gen->options->n_overloads; i++) {
+        size_t arity;
+        unsigned floats;
+
+        fcgen_signature(i, &arity, &floats);
+
+        fprintf(gen->file, "def over(");
+        for (size_t j = 0; j < arity; j++) {
+            fprintf(gen->file, "%sp%zu: %s", j == 0 ? "" : ", ", j,
+                    floats & (1U << j) ? "Float" : "Int");
+        }
+        fprintf(gen->file, ") -> Int {\n    return %zu;\n}\n\n", i);
+    }
+}
+
+/* Terms are parameters, literals, instructions or calls. Calls only target
+   earlier functions and the overload set */
+void fcgen_term(fcgen_t *gen, size_t function) {
+    size_t kind = fcgen_below(gen, 6);
+
+    if (kind == 4 && function > 0) {
+        fprintf(gen->file, "f%zu(b, a)", fcgen_below(gen, function));
+    } else if (kind == 5 && gen->options->n_overloads > 0) {
+        size_t arity;
+        unsigned floats;
+
+        fcgen_signature(fcgen_below(gen, gen->options->n_overloads),
+                        &arity, &floats);
+
+        fprintf(gen->file, "over(");
+        for (size_t j = 0; j < arity; j++) {
+            fprintf(gen->file, "%s%s", j == 0 ? "" : ", ",
+                    floats & (1U << j) ? "%itof(a)" : "b");
+        }
+        fprintf(gen->file, ")");
+    } else if (kind == 3) {
+        size_t op = fcgen_below(gen, FCGEN_N_OPERATORS);
+        fprintf(gen->file, "%%%s(a, %zu)", fcgen_mnemonics[op],
+                fcgen_below(gen, 100) + 1);
+    } else if (kind == 2) {
+        fprintf(gen->file, "%zu", fcgen_below(gen, 1000));
+    } else {
+        fprintf(gen->file, "%c", kind == 0 ? 'a' : 'b');
+    }
+}
+
+void fcgen_expression(fcgen_t *gen, size_t function) {
+    size_t n = gen->options->chain;
+
+    if (n == 0) {
+        n = 1;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (i > 0) {
+            size_t op = fcgen_below(gen, FCGEN_N_OPERATORS);
+            fprintf(gen->file, " %s ", fcgen_operators[op]);
+        }
+
+        if (fcgen_below(gen, 8) == 0 && i + 1 < n) {
+            fprintf(gen->file, "(");
+            fcgen_term(gen, function);
+            fprintf(gen->file, " + ");
+            fcgen_term(gen, function);
+            fprintf(gen->file, ")");
+        } else {
+            fcgen_term(gen, function);
+        }
+    }
+}
+
+void fcgen_indent(fcgen_t *gen, size_t level) {
+    for (size_t i = 0; i < level && i < FCGEN_MAX_INDENT; i++) {
+        fputs("    ", gen->file);
+    }
+}
+
+void fcgen_function(fcgen_t *gen, size_t function) {
+    size_t depth = gen->options->depth;
+
+    fprintf(gen->file, "def f%zu(a: Int, b: Int) -> Int {\n", function);
+
+    for (size_t i = 0; i < depth; i++) {
+        fcgen_indent(gen, i + 1);
+        fprintf(gen->file, "%s (a < %zu) {\n",
+                fcgen_below(gen, 2) ? "if" : "while",
+                fcgen_below(gen, 1000));
+    }
+
+    fcgen_indent(gen, depth + 1);
+    fprintf(gen->file, "return ");
+    fcgen_expression(gen, function);
+    fprintf(gen->file, ";\n");
+
+    for (size_t i = depth; i > 0; i--) {
+        fcgen_indent(gen, i);
+        fprintf(gen->file, "}\n");
+    }
+
+    fprintf(gen->file, "    return ");
+    fcgen_expression(gen, function);
+    fprintf(gen->file, ";\n}\n\n");
+}
+
+void fcgen_usage(char const *name) {
+    fprintf(stderr,
+            "usage: %s [options] <output>\n"
+            "options:\n"
+            "  --seed=<n>        random seed, default 1\n"
+            "  --functions=<n>   functions, default 1000\n"
+            "  --overloads=<n>   signatures of one overloaded function, "
+            "default 0\n"
+            "  --chain=<n>       terms per expression, default 4\n"
+            "  --depth=<n>       nested if/while per function, default 1\n",
+            name);
+}
+
+int fcgen_parse(fcgen_options_t *options, int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        char *arg = argv[i];
+        char *value = strchr(arg, '=');
+        char *end;
+        unsigned long long n = 0;
+
+        if (strncmp(arg, "--", 2) == 0 && value != NULL) {
+            n = strtoull(value + 1, &end, 10);
+            if (value[1] == '\0' || *end != '\0') {
+                return 1;
+            }
+        }
+
+        if (strncmp(arg, "--seed=", 7) == 0) {
+            options->seed = n;
+        } else if (strncmp(arg, "--functions=", 12) == 0) {
+            options->n_functions = n;
+        } else if (strncmp(arg, "--overloads=", 12) == 0) {
+            options->n_overloads = n;
+        } else if (strncmp(arg, "--chain=", 8) == 0) {
+            options->chain = n;
+        } else if (strncmp(arg, "--depth=", 8) == 0) {
+            options->depth = n;
+        } else if (arg[0] != '-' && options->output == NULL) {
+            options->output = arg;
+        } else {
+            return 1;
+        }
+    }
+
+    /* Signatures are limited by FCGEN_MAX_ARITY */
+    size_t max_overloads = ((size_t)1 << (FCGEN_MAX_ARITY + 1)) - 2;
+
+    return options->output == NULL || options->n_overloads > max_overloads;
+}
+
+int main(int argc, char *argv[]) {
+    fcgen_options_t options = { 1, 1000, 0, 4, 1, NULL };
+    fcgen_t gen;
+
+    if (fcgen_parse(&options, argc, argv)) {
+        fcgen_usage(argv[0]);
+        return 1;
+    }
+
+    if ((gen.file = fopen(options.output, "w")) == NULL) {
+        perror(options.output);
+        return 1;
+    }
+
+    /* xorshift has no zero state */
+    gen.state = options.seed * 0x9E3779B97F4A7C15ULL + 1;
+    gen.options = &options;
+
+    fcgen_prelude(&gen);
+    fcgen_overloads(&gen);
+
+    for (size_t i = 0; i < options.n_functions; i++) {
+        fcgen_function(&gen, i);
+    }
+
+    fprintf(gen.file, "def main() -> Int {\n    return %s;\n}\n",
+            options.n_functions > 0 ? "f0(1, 2)" : "0");
+
+    if (fclose(gen.file) != 0) {
+        perror(options.output);
+        return 1;
+    }
+
+    return 0;
+}
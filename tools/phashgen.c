@@ -0,0 +1,158 @@
+#include "phash.h"
+#include "parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Generates the minimal perfect hash tables included by src/phash.c. Links
+   against phash.c built with FUCO_PHASH_BOOTSTRAP, so only the hash function
+   itself is shared with the compiler */
+
+#define PHASHGEN_MAX_KEYS 64
+
+#define PHASHGEN_MAX_SEED 100000000U
+
+typedef struct {
+    char const *name;
+    char const *keys[PHASHGEN_MAX_KEYS];
+    uint32_t values[PHASHGEN_MAX_KEYS];
+    size_t size;
+} phashgen_set_t;
+
+void phashgen_set_add(phashgen_set_t *set, char const *key, uint32_t value) {
+    if (set->size >= PHASHGEN_MAX_KEYS) {
+        fprintf(stderr, "phashgen: too many keys in %s\n", set->name);
+        exit(1);
+    }
+
+    if (strchr(key, '"') != NULL || strchr(key, '\\') != NULL) {
+        fprintf(stderr, "phashgen: cannot emit key '%s'\n", key);
+        exit(1);
+    }
+
+    set->keys[set->size] = key;
+    set->values[set->size] = value;
+    set->size++;
+}
+
+void phashgen_set_tokenkind(phashgen_set_t *set, char const *name,
+                            fuco_tokenkind_t kind) {
+    set->name = name;
+    set->size = 0;
+
+    for (size_t i = 0; i < FUCO_N_TOKENTYPES; i++) {
+        if (fuco_tokentype_kind(i) == kind) {
+            phashgen_set_add(set, fuco_tokentype_string(i), i);
+        }
+    }
+}
+
+void phashgen_set_instrs(phashgen_set_t *set, char const *name) {
+    set->name = name;
+    set->size = 0;
+
+    for (size_t i = 0; i < FUCO_INSTR_OPCODES_N; i++) {
+        fuco_opcode_t opcode = fuco_instr_opcodes[i];
+
+        phashgen_set_add(set, fuco_opcode_get_mnemonic(opcode), opcode);
+    }
+}
+
+/* Returns the slot of each key under seed, or false on a collision */
+bool phashgen_try_seed(phashgen_set_t *set, uint32_t seed, size_t *slots) {
+    bool used[PHASHGEN_MAX_KEYS] = { false };
+
+    for (size_t i = 0; i < set->size; i++) {
+        char const *key = set->keys[i];
+        size_t slot = fuco_phash(seed, key, strlen(key)) % set->size;
+
+        if (used[slot]) {
+            return false;
+        }
+
+        used[slot] = true;
+        slots[i] = slot;
+    }
+
+    return true;
+}
+
+int phashgen_emit(phashgen_set_t *set, FILE *file) {
+    size_t slots[PHASHGEN_MAX_KEYS];
+    size_t order[PHASHGEN_MAX_KEYS];
+    uint32_t seed;
+
+    for (seed = 0; seed < PHASHGEN_MAX_SEED; seed++) {
+        if (phashgen_try_seed(set, seed, slots)) {
+            break;
+        }
+    }
+
+    if (seed == PHASHGEN_MAX_SEED) {
+        fprintf(stderr, "phashgen: no perfect hash found for %s\n",
+                set->name);
+        return 1;
+    }
+
+    for (size_t i = 0; i < set->size; i++) {
+        order[slots[i]] = i;
+    }
+
+    fprintf(file, "static fuco_phash_entry_t const %s_entries[] = {\n",
+            set->name);
+
+    for (size_t i = 0; i < set->size; i++) {
+        fprintf(file, "    { \"%s\", %u }%s\n", set->keys[order[i]],
+                set->values[order[i]], i + 1 < set->size ? "," : "");
+    }
+
+    fprintf(file, "};\n\n");
+    fprintf(file, "static fuco_phash_table_t const %s = {\n", set->name);
+    fprintf(file, "    %s_entries, %zu, %u\n", set->name, set->size, seed);
+    fprintf(file, "};\n\n");
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <output>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *file = fopen(argv[1], "w");
+
+    if (file == NULL) {
+        perror("phashgen");
+        return 1;
+    }
+
+    phashgen_set_t set;
+    int error = 0;
+
+    fprintf(file, "/* Generated by tools/phashgen, do not edit */\n\n");
+
+    phashgen_set_tokenkind(&set, "fuco_phash_keywords",
+                           FUCO_TOKENKIND_KEYWORD);
+    error = error || phashgen_emit(&set, file);
+
+    phashgen_set_tokenkind(&set, "fuco_phash_separators",
+                           FUCO_TOKENKIND_SEPARATOR);
+    error = error || phashgen_emit(&set, file);
+
+    phashgen_set_tokenkind(&set, "fuco_phash_operators",
+                           FUCO_TOKENKIND_OPERATOR);
+    error = error || phashgen_emit(&set, file);
+
+    phashgen_set_instrs(&set, "fuco_phash_instrs");
+    error = error || phashgen_emit(&set, file);
+
+    fclose(file);
+
+    if (error) {
+        remove(argv[1]);
+    }
+
+    return error;
+}